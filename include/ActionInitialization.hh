@@ -0,0 +1,33 @@
+
+#ifndef ACTIONINITIALIZATION_HH_
+#define ACTIONINITIALIZATION_HH_
+
+#include "G4VUserActionInitialization.hh"
+
+class DetectorConstruction;
+
+/*
+ * User's ActionInitialization class
+ * Builds the user action classes. In a multithreaded run Build() is
+ * called once for every worker thread, so each thread gets its own
+ * PrimaryGeneratorAction, EventAction, RunAction and SteppingAction.
+ * BuildForMaster() only creates the RunAction of the master thread.
+ */
+
+class ActionInitialization : public G4VUserActionInitialization
+{
+public:
+	// constructor
+	ActionInitialization( DetectorConstruction* myDet );
+	// destructor
+	virtual ~ActionInitialization() {};
+	// Create the run action of the master thread
+	virtual void BuildForMaster() const;
+	// Create the user actions of a worker thread (or of the sequential run)
+	virtual void Build() const;
+private:
+	// Pointer to the (shared) DetectorConstruction
+	DetectorConstruction* myDetector;
+};
+
+#endif /* ACTIONINITIALIZATION_HH_ */
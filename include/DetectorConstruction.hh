@@ -10,6 +10,8 @@
 
 class G4LogicalVolume;
 class G4VPhysicalVolume;
+class G4Region;
+class G4VSensitiveDetector;
 //class G4Material;
 class DetectorMessenger;
 
@@ -30,6 +32,9 @@ public:
   // Construct geometry of the setup
   G4VPhysicalVolume* Construct();
 
+  // Construct and attach the sensitive detectors (called once per thread)
+  void ConstructSDandField();
+
   // Update geometry
   void UpdateGeometry();
 
@@ -111,6 +116,12 @@ public:
   G4double Get_x1_SensorAngle() const { return x1_SensorTheta; }
   G4double Get_u1_SensorAngle() const { return u1_SensorTheta; }
   G4double Get_v1_SensorAngle() const { return v1_SensorTheta; }
+  // World centre and stereo angle of strip plane 0..Get_nb_of_planes()-1 (DetectorPlanes numbering) as built,
+  // phantom placement and offsets included. False for a plane that has no volume in this geometry
+  G4bool Get_strip_plane_placement( const G4int plane, G4ThreeVector& pos, G4double& angle ) const;
+  // Placed volume and DUT flag of strip/pixel plane (DetectorPlanes numbering), null if the plane is not built
+  G4VPhysicalVolume* Get_strip_plane_volume( const G4int plane, G4bool& isDUT ) const;
+  G4VPhysicalVolume* Get_pixel_plane_volume( const G4int plane, G4bool& isDUT ) const;
 
   G4ThreeVector Get_PhantomPosition() const { return pos_phantom; }
   G4double Get_PhantomAngle() const { return phantomTheta; }
@@ -131,6 +142,27 @@ public:
     G4bool   Set_strip_det_build( const G4bool& flag ) { return build_strip_detectors=flag; }
     G4bool   Set_pixel_det_build( const G4bool& flag ) { return build_pixel_detectors=flag; }
     
+    // Digitization: only channels with charge get a digit, noise-only channels above threshold are drawn statistically
+    G4bool   Set_sparse_digitization( const G4bool& flag ) { return sparse_digitization=flag; }
+    G4double Set_digi_noise_threshold( const G4double& thr ) { return digi_noise_threshold=thr; }
+    
+    // Step limits and production cuts per region, set by macro for the sensors and the neutron
+    // converter film (max step <= 0: no limit, cut <= 0: physics list default, both by default).
+    // Applied straight away if the regions already exist.
+    void     Set_sensor_max_step( const G4double& step );
+    void     Set_converter_max_step( const G4double& step );
+    void     Set_other_max_step( const G4double& step );
+    void     Set_sensor_prod_cut( const G4double& cut );
+    void     Set_converter_prod_cut( const G4double& cut );
+    
+    // Importance biasing through the shields (pstep -b): number of slabs per shield and
+    // importance ratio between consecutive slabs, used when the geometry is (re)built
+    G4int    Set_importance_slabs( const G4int& n ) { return importance_slabs=n; }
+    G4double Set_importance_ratio( const G4double& r ) { return importance_ratio=r; }
+    
+    // Forced neutron interaction in the converter film (pstep -f), must be set before initialisation
+    G4bool   Set_force_converter_collision( const G4bool& flag ) { return force_converter_collision=flag; }
+    
     // Pixel detector
     G4bool   Set_pix1_SensorDUTSetup( const G4bool& flag ) { return is_pix1_PlaneDUT=flag; }
     G4bool   Set_pix2_SensorDUTSetup( const G4bool& flag ) { return is_pix2_PlaneDUT=flag; }
@@ -169,6 +201,9 @@ public:
   G4double Get_halfPhantomSizeZ()      {return halfPhantomSizeZ;}
 
   G4double Get_halfShieldSizeZ()      {return halfShieldSizeZ;} //*******************
+  G4double Get_halfShieldSizeXY()     {return halfShieldSizeXY;}
+  G4double Get_halfWorldLengthXY()    {return halfWorldLengthXY;}
+  G4double Get_halfWorldLengthZ()     {return halfWorldLengthZ;}
 
   //********************************************************************************************************************************
  G4double Get_film_gap()           {return film_gap;}
@@ -180,6 +215,7 @@ public:
   //*******************************************************************
    G4double Get_contact2_gap()           {return contact2_gap;}
    G4double Get_halfContact2SizeZ()      {return halfContact2SizeZ;}
+   G4double Get_halfContact2SizeXY()     {return halfContact2SizeXY;}
   //********************************************************************************************************************************
 
   G4double Get_strip_length()          {return sensorStripLength;}
@@ -212,6 +248,11 @@ public:
  
   G4bool Get_build_strip_detectors() const {return build_strip_detectors;}
   G4bool Get_build_pixel_detectors() const {return build_pixel_detectors;}
+  G4bool Get_sparse_digitization() const {return sparse_digitization;}
+  G4double Get_digi_noise_threshold() const {return digi_noise_threshold;}
+  G4int Get_importance_slabs() const {return importance_slabs;}
+  G4double Get_importance_ratio() const {return importance_ratio;}
+  G4bool Get_force_converter_collision() const {return force_converter_collision;}
     
   G4Material* GetWorldMaterial()          {return world_material;}
   G4Material* GetDetectorMaterial()       {return detector_material;}
@@ -232,12 +273,37 @@ private:
     
   // initialize geometry parameters
   void ComputeParameters();
+    
+  // put the step limits and production cuts on the sensor/converter/world regions
+  void ApplyRegionSettings();
+  // own production cut of a region, or the physics list default for cut <= 0
+  void SetRegionProductionCut( G4Region* region, G4double cut );
+  // binds the SD of a plane to its sensor (DUT: to its strips/rows), warns if the plane is not built
+  void AttachSensitiveDetector( G4VPhysicalVolume* plane, const G4bool isDUT, G4VSensitiveDetector* sensitive_det );
 
 private:
 
     // Boolean
     G4bool build_strip_detectors;
     G4bool build_pixel_detectors;
+    G4bool sparse_digitization;
+    G4double digi_noise_threshold;      // in elementary charge units
+    
+    // Regions with their own step limit and production cuts
+    G4Region* sensorRegion;             // pixel and strip sensor planes
+    G4Region* converterRegion;          // neutron converter film
+    G4double sensor_max_step;           // <= 0 for no limit
+    G4double converter_max_step;
+    G4double other_max_step;            // rest of the world
+    G4double sensor_prod_cut;           // <= 0 for the physics list default
+    G4double converter_prod_cut;
+    
+    // Importance biasing slabs (see ImportanceWorld)
+    G4int importance_slabs;             // per shield
+    G4double importance_ratio;          // between consecutive slabs
+    
+    // Force the neutrons crossing the converter film to interact (generic biasing)
+    G4bool force_converter_collision;
     
     //Materials
 
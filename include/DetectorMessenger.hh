@@ -11,6 +11,7 @@ class DetectorConstruction;
 class G4UIdirectory;
 class G4UIcmdWithAString;
 class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithADouble;
 class G4UIcmdWithAnInteger;
 class G4UIcmdWith3VectorAndUnit;
 class G4UIcmdWithoutParameter;
@@ -163,6 +164,21 @@ private:
     // Pixel detector
     
     G4UIcmdWithABool*			build_pixel_detCmd;
+    G4UIcmdWithABool*			sparse_digiCmd;
+    G4UIcmdWithADouble*			digi_noise_thresholdCmd;
+    
+    // Step limits and production cuts per region
+    G4UIdirectory*              stepDir;
+    G4UIcmdWithADoubleAndUnit*  sensor_max_stepCmd;
+    G4UIcmdWithADoubleAndUnit*  converter_max_stepCmd;
+    G4UIcmdWithADoubleAndUnit*  other_max_stepCmd;
+    G4UIcmdWithADoubleAndUnit*  sensor_prod_cutCmd;
+    G4UIcmdWithADoubleAndUnit*  converter_prod_cutCmd;
+    
+    // Importance biasing slabs in the shields
+    G4UIdirectory*              biasingDir;
+    G4UIcmdWithAnInteger*       importance_slabsCmd;
+    G4UIcmdWithADouble*         importance_ratioCmd;
     
     G4UIdirectory*              pix1_SensorDir;
     G4UIdirectory*              pix2_SensorDir;
@@ -0,0 +1,37 @@
+#ifndef DETECTORPLANES_HH_
+#define DETECTORPLANES_HH_
+
+#include "globals.hh"
+#include <sstream>
+
+/*
+ * Names of the detector planes, shared by the sensitive detectors, the digitizers,
+ * EventAction and RootSaver so that they can all loop over a plane index.
+ *
+ * Strip planes follow the stereo pattern x1,u1,v1,x2,u2,v2,... and pixel planes are
+ * pix1,pix2,... The hits collection of a plane is named after its sensitive detector,
+ * e.g. SiStrip_u1 or SiPixel_pix3. The number of planes comes from
+ * DetectorConstruction::Get_nb_of_planes() and Get_nb_of_pix_planes().
+ */
+class DetectorPlanes
+{
+public:
+    static G4String StripPlaneName( const G4int plane )
+    {
+        std::ostringstream name;
+        name << "xuv"[plane%3] << plane/3 + 1;
+        return name.str();
+    }
+
+    static G4String PixelPlaneName( const G4int plane )
+    {
+        std::ostringstream name;
+        name << "pix" << plane + 1;
+        return name.str();
+    }
+
+    static G4String StripHitsCollectionName( const G4int plane ) { return "SiStrip_" + StripPlaneName(plane); }
+    static G4String PixelHitsCollectionName( const G4int plane ) { return "SiPixel_" + PixelPlaneName(plane); }
+};
+
+#endif /* DETECTORPLANES_HH_ */
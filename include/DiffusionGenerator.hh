@@ -5,8 +5,7 @@
 #define DIFFUSIONGENERATOR_HH_
 
 #include <TMath.h>
-
-#include "TrackerGeometry.hh"
+#include <vector>
 
 //simulates charge diffusion between strips
 
@@ -18,8 +17,9 @@ public:
     //Constructor
     DiffusionGenerator();
 
-    //Constructor with bias voltage value
-    DiffusionGenerator(const double& bias);
+    //Constructor with bias voltage value (V) and det. thickness (mm). The thickness comes from the
+    //geometry of the digitizer that owns the generator, see SiDigitizer::ReSetSensorGeometry()
+    DiffusionGenerator(const double& bias, const double& thickness);
     
     //Destructor
     ~DiffusionGenerator();
@@ -30,16 +30,22 @@ public:
     double get_bias_voltage()    const { return Vb; }
     double get_det_thickness()   const { return det_thickness; }
 
-    double get_charge_frac(double limits[]);
+    double get_charge_frac(double limits[]) const;
     double* get_igral_limits(double limits[], double det_strip_origin, double det_hit_pos, double s_pitch);
     
 private:
 
+    //Tabulate the fraction of the (gaussian) charge cloud found below x, 0.5*(1+erf(x/(sigma*sqrt(2)))),
+    //once sigma is known. get_charge_frac() then interpolates it instead of calling TMath::Erf
+    void build_kernel();
+    //Fraction of the charge below x (hit at 0), linear interpolation in the table
+    inline double get_edge_frac(double x) const;
+
     double sigma, k, e, d, det_thickness;
     float T, Vb;
-    //The object that handles the tracker geometry used in charge diffusion
-    //And is used by the MakeDiffusion() function.
-    TrackerGeometry tracker;
+    //Table of the charge fraction below x for x in [kernel_x0, -kernel_x0], kernel_inv_step bins per mm
+    std::vector<double> kernel;
+    double kernel_x0, kernel_inv_step;
     
 };
 
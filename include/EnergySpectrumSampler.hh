@@ -0,0 +1,55 @@
+#ifndef ENERGYSPECTRUMSAMPLER_HH_
+#define ENERGYSPECTRUMSAMPLER_HH_
+
+#include "globals.hh"
+
+#include <vector>
+
+/*
+ * Samples the kinetic energy of the primaries from a tabulated spectrum.
+ *
+ * The spectrum (points E, dN/dE as for /gps/hist/point with /gps/ene/type Arb)
+ * is read from a text file and interpolated (linear or natural cubic spline, like
+ * /gps/hist/inter Lin|Spline) onto a fine grid of equal width bins. A Walker
+ * alias table built on the bins makes each sample O(1): one bin look-up and
+ * a uniform position inside the bin, no search and no interpolation per primary.
+ */
+class EnergySpectrumSampler
+{
+public:
+    EnergySpectrumSampler();
+    ~EnergySpectrumSampler() {};
+    
+    // Read the spectrum: one "energy(MeV) intensity" pair per line, # starts a comment
+    G4bool LoadFile( const G4String& fileName );
+    void SetSpline( G4bool spline ) { useSpline = spline; tableReady = false; }
+    void SetNumberOfBins( G4int n ) { nBins = n; tableReady = false; }
+    
+    G4bool IsLoaded() const { return !points_E.empty(); }
+    
+    // Build the alias table (done at the start of the run), false if it can not be built
+    G4bool BuildTable();
+    G4bool IsReady() const { return tableReady; }
+    
+    // Kinetic energy, in Geant4 units (the table must be built)
+    G4double Sample() const;
+    
+private:
+    G4double Interpolate( G4double e ) const;
+    
+    // Tabulated spectrum
+    std::vector<G4double> points_E;
+    std::vector<G4double> points_I;
+    std::vector<G4double> secondDerivatives;    // for the natural cubic spline
+    G4bool useSpline;
+    
+    // Alias table on nBins equal bins between the first and the last point
+    G4int nBins;
+    G4double eMin;
+    G4double binWidth;
+    std::vector<G4double> aliasProb;
+    std::vector<G4int> alias;
+    G4bool tableReady;
+};
+
+#endif /* ENERGYSPECTRUMSAMPLER_HH_ */
@@ -5,9 +5,11 @@
 
 #include "G4UserEventAction.hh"
 #include "G4String.hh"
+#include "G4ThreeVector.hh"
 #include "NoiseGenerator.hh"
 #include "CrosstalkGenerator.hh"
 #include "MeV2ChargeConverter.hh"
+#include <vector>
 
 class G4Event;
 class RootSaver;
@@ -38,16 +40,14 @@ private:
 	//pointer to saver object
 	RootSaver* rootSaver;
     
-	//hits collection name
-	G4String hitsCollName_x1;
-	G4String hitsCollName_u1;
-	G4String hitsCollName_v1;
+	//hits collection IDs of the strip and pixel planes, indexed by plane (see DetectorPlanes)
+	std::vector<G4int> hitsCollIDs_strip;
+	std::vector<G4int> hitsCollIDs_pix;
+	void UpdateHitsCollectionIDs( std::vector<G4int>& ids, const G4int nPlanes, const G4bool pixels );
     
-    //hits collection name
-    G4String hitsCollName_pix1;
-    G4String hitsCollName_pix2;
-    G4String hitsCollName_pix3;
-    G4String hitsCollName_pix4;
+	//world placement of the strip planes passed to the digitizer, refilled every event
+	std::vector<G4ThreeVector> stripPlanePositions;
+	std::vector<G4double> stripPlaneAngles;
     
 	//digits collection name
 	G4String digitsCollName;
@@ -0,0 +1,48 @@
+#ifndef EVENTSEEDER_HH_
+#define EVENTSEEDER_HH_
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class G4Event;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+
+/*
+ * Deterministic per-event seeding.
+ *
+ * Every event is started from seeds derived from (run seed, run ID, event ID) with a
+ * counter-based hash (SplitMix64), so the random sequence of an event does not depend
+ * on the events simulated before it, on the thread that simulates it or on the number
+ * of threads. A single event can then be regenerated on its own:
+ *   pstep -s <run seed> replay.mac   with   /det/random/replay <run ID> <event ID>
+ *                                           /run/beamOn 1
+ * The run seed is given with pstep -s, otherwise it is taken from the clock and printed.
+ *
+ * Created once, by main(), on the master. The settings are read by the worker
+ * threads only while events are processed.
+ */
+class EventSeeder : public G4UImessenger
+{
+public:
+    EventSeeder( G4long seed );
+    virtual ~EventSeeder();
+    
+    // Reseed the engine of the calling thread for this event (from GeneratePrimaries)
+    static void SeedEvent( const G4Event* anEvent );
+    
+    static G4long GetRunSeed() { return runSeed; }
+    
+    void SetNewValue( G4UIcommand*, G4String );
+    
+private:
+    static G4long runSeed;
+    // /det/random/replay: run ID and first event ID used for the seeds of the next run (-1: off)
+    static G4int replayRunID;
+    static G4int replayEventID;
+    
+    G4UIdirectory* randomDir;
+    G4UIcmdWithAString* replayCmd;
+};
+
+#endif /* EVENTSEEDER_HH_ */
@@ -0,0 +1,48 @@
+#ifndef FASTSOURCE_HH_
+#define FASTSOURCE_HH_
+
+#include "G4VPrimaryGenerator.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class G4Event;
+class G4ParticleGun;
+
+/*
+ * Compact source built on G4ParticleGun, for the simple sources used in production:
+ *  - position: a point or a uniform disk (perpendicular to the axis) around the centre
+ *  - direction: isotropic, beam2d (gaussian angles around the axis, as the GPS beam2d)
+ *    or fixed along the axis
+ *  - energy: /gun/energy, or the tabulated spectrum of /det/gun/energySpectrum
+ * Particle and energy are set with the usual /gun/ commands, the rest with /det/gun/fast/.
+ * Much cheaper per event than G4GeneralParticleSource.
+ */
+class FastSource : public G4VPrimaryGenerator
+{
+public:
+    enum AngularType { iso, beam2d, fixed };
+    
+    FastSource();
+    virtual ~FastSource();
+    
+    void GeneratePrimaryVertex( G4Event* anEvent );
+    
+    void SetCentre( const G4ThreeVector& pos ) { centre = pos; }
+    void SetAxis( const G4ThreeVector& dir ) { axis = dir.unit(); }
+    void SetDiskRadius( G4double r ) { diskRadius = r; }
+    void SetAngularType( AngularType type ) { angularType = type; }
+    AngularType GetAngularType() const { return angularType; }
+    void SetBeamSigmaX( G4double sigma ) { beamSigmaX = sigma; }
+    void SetBeamSigmaY( G4double sigma ) { beamSigmaY = sigma; }
+    
+private:
+    G4ParticleGun* particleGun;
+    G4ThreeVector centre;
+    G4ThreeVector axis;
+    G4double diskRadius;        // 0 for a point source
+    AngularType angularType;
+    G4double beamSigmaX;
+    G4double beamSigmaY;
+};
+
+#endif /* FASTSOURCE_HH_ */
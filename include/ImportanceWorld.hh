@@ -0,0 +1,51 @@
+#ifndef IMPORTANCEWORLD_HH_
+#define IMPORTANCEWORLD_HH_
+
+#include "G4VUserParallelWorld.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class DetectorConstruction;
+class G4VPhysicalVolume;
+
+/*
+ * Parallel world used for geometric importance biasing of the neutrons
+ * through the PE (Shield) and Pb (Contact2) shielding.
+ *
+ * Each shield is covered by Get_importance_slabs() ghost slabs along z. Going
+ * downstream the importance of every slab is Get_importance_ratio() times the
+ * one of the previous slab, and the volume behind the last slab (converter and
+ * sensors) keeps the last importance. A neutron crossing into a more important
+ * slab is split, one going back is played Russian roulette; the weight of the
+ * tracks is stored with the hits so that the tallies stay unbiased.
+ *
+ * Enabled with pstep -b (the biasing physics must be registered before the
+ * run manager is initialised).
+ */
+class ImportanceWorld : public G4VUserParallelWorld
+{
+public:
+    ImportanceWorld( const G4String& worldName, DetectorConstruction* myDC );
+    virtual ~ImportanceWorld() {};
+    
+    // Builds the ghost slabs
+    virtual void Construct();
+    // Fills the importance store of the calling thread
+    virtual void ConstructSD();
+    
+    G4VPhysicalVolume* GetWorldVolume() const { return ghostWorld; }
+    
+private:
+    // Ghost slabs covering one shield, world position and z rotation of the shield
+    void BuildSlabs( const G4ThreeVector& pos, G4double theta, G4double halfXY, G4double halfZ, G4LogicalVolume* mother );
+    
+    DetectorConstruction* myDetector;
+    G4VPhysicalVolume* ghostWorld;
+    // Slabs in order along the beam (the n-th slab has importance ratio^(n+1)),
+    // followed by the downstream cell which has the importance of the last slab
+    std::vector<G4VPhysicalVolume*> cells;
+    G4int nSlabCells;
+};
+
+#endif /* IMPORTANCEWORLD_HH_ */
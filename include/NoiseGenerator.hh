@@ -26,6 +26,16 @@ public:
    * if sigma<0 do not smear
    */
   virtual G4double operator() ();
+  /* Probability that the noise exceeds threshold
+   * Used by the sparse digitization to get the expected number
+   * of noise-only channels over threshold without sampling each channel
+   */
+  virtual G4double ProbabilityAbove(const G4double& threshold) const;
+  /* Generate noise conditioned on being above threshold
+   * i.e. sample the tail of the gaussian beyond threshold
+   * if sigma<0 do not smear
+   */
+  virtual G4double FireAbove(const G4double& threshold);
   /* copy and assignement operators
    * These methods are needed since
    * randomGauss should not be copied
@@ -0,0 +1,50 @@
+#ifndef PHASESPACEGENERATOR_HH_
+#define PHASESPACEGENERATOR_HH_
+
+#include "G4VPrimaryGenerator.hh"
+#include "PhaseSpaceWriter.hh"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+class G4Event;
+
+/*
+ * Primary generator replaying a phase-space file written by PhaseSpaceWriter.
+ * All the particles recorded for one first stage event are generated in the
+ * same G4Event (one primary vertex each, carrying the recorded weight), so that
+ * coincidences between the particles reaching the converter/sensors are kept.
+ *
+ * The file is shared by all the worker threads: each event is read under a lock,
+ * the file is rewound (with a warning) when all its events have been used.
+ * Results are normalised to the number of first stage events stored in the header.
+ */
+class PhaseSpaceGenerator : public G4VPrimaryGenerator
+{
+public:
+    PhaseSpaceGenerator();
+    virtual ~PhaseSpaceGenerator() {};
+    
+    // Open the file (shared by all threads, re-opened only if the name changes)
+    G4bool SetFileName( const G4String& name );
+    
+    void GeneratePrimaryVertex( G4Event* anEvent );
+    
+private:
+    // Read the records of the next event into the buffer, returns the number of records
+    static size_t ReadNextEvent( std::vector<PhaseSpaceRecord>& buffer );
+    static G4bool ReadRecord( PhaseSpaceRecord& rec );
+    static G4bool Rewind();
+    
+    std::vector<PhaseSpaceRecord> eventRecords;
+    
+    static std::string fileName;
+    static std::ifstream* input;
+    static PhaseSpaceHeader header;
+    // Look-ahead record: the first particle of the next event
+    static PhaseSpaceRecord nextRecord;
+    static G4bool hasNextRecord;
+};
+
+#endif /* PHASESPACEGENERATOR_HH_ */
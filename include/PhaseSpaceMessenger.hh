@@ -0,0 +1,29 @@
+#ifndef PHASESPACEMESSENGER_HH_
+#define PHASESPACEMESSENGER_HH_
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class PhaseSpaceWriter;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithABool;
+
+class PhaseSpaceMessenger : public G4UImessenger
+{
+public:
+	// Constructor
+	PhaseSpaceMessenger(PhaseSpaceWriter*);
+	// Destructor
+	virtual ~PhaseSpaceMessenger();
+	// handle user commands
+	void SetNewValue(G4UIcommand*,G4String);
+private:
+	PhaseSpaceWriter*			writer;
+
+	G4UIdirectory*				phaseSpaceDir;
+	G4UIcmdWithAString*			recordCmd;
+	G4UIcmdWithABool*			killRecordedCmd;
+};
+
+#endif /* PHASESPACEMESSENGER_HH_ */
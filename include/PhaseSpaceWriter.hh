@@ -0,0 +1,99 @@
+#ifndef PHASESPACEWRITER_HH_
+#define PHASESPACEWRITER_HH_
+
+#include "globals.hh"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+class G4Track;
+class G4Region;
+class PhaseSpaceMessenger;
+
+/*
+ * One particle crossing the scoring boundary, as stored in the phase-space file.
+ * Positions in mm (world coordinates), energy in MeV, time in ns.
+ * Floats are plenty for replaying and keep a record at 44 bytes.
+ */
+struct PhaseSpaceRecord
+{
+    G4int   eventID;        // event of the first stage, used to group the particles of one event
+    G4int   pdgCode;
+    G4float x, y, z;
+    G4float dx, dy, dz;     // momentum direction
+    G4float kineticEnergy;
+    G4float time;
+    G4float weight;
+};
+
+/*
+ * File header, rewritten when the file is closed.
+ * nEvents is the number of first stage events the file corresponds to (for normalisation).
+ */
+struct PhaseSpaceHeader
+{
+    char    magic[8];       // "PSTEPPS"
+    G4int   version;
+    G4int   recordSize;
+    G4long  nEvents;
+    G4long  nRecords;
+};
+
+/*
+ * Writes a binary phase-space file with every particle entering the converter film
+ * or the sensor planes (ConverterRegion / SensorRegion set up in DetectorConstruction).
+ * The file is replayed by PhaseSpaceGenerator so that converter and sensor studies
+ * do not need to transport the source through the Pb and PE shielding again.
+ *
+ * Recording is switched on with /det/phaseSpace/record <file name>.
+ * Like RootSaver, each worker of a MT run writes its own file and the
+ * master joins them at the end of the run.
+ */
+class PhaseSpaceWriter
+{
+public:
+    PhaseSpaceWriter();
+    virtual ~PhaseSpaceWriter();
+    
+    // Base name of the output file ("" or "none" to switch recording off)
+    void SetFileBaseName( const G4String& name );
+    G4bool IsEnabled() const { return !baseName.empty(); }
+    const G4String& GetFileBaseName() const { return baseName; }
+    
+    // Stop the recorded tracks (default). The first stage then only transports up to the
+    // boundary and particles scattered back out cannot be recorded twice
+    void SetKillRecorded( G4bool kill ) { killRecorded = kill; }
+    G4bool GetKillRecorded() const { return killRecorded; }
+    
+    // Open a new file, nothing is done if recording is off
+    G4bool Open( const std::string& fileName );
+    // Close the file, nEvents is the number of events processed
+    void Close( G4long nEvents );
+    G4bool IsOpen() const { return output != 0; }
+    const std::string& GetFileName() const { return fileName; }
+    
+    // True if the region is part of the scored (converter/sensor) volume
+    inline G4bool IsInside( const G4Region* region ) const
+    { return region != 0 && ( region == converterRegion || region == sensorRegion ); }
+    
+    // Store the track as it crosses into the scored volume
+    void Fill( G4int eventID, const G4Track* track );
+    
+    // Join the per-thread files of a multithreaded run into outFile, input files are deleted
+    static G4bool MergeFiles( const std::vector<std::string>& inFiles, const std::string& outFile );
+    
+private:
+    void WriteHeader();
+    
+    G4String baseName;
+    G4bool killRecorded;
+    std::string fileName;
+    std::ofstream* output;
+    PhaseSpaceHeader header;
+    const G4Region* converterRegion;
+    const G4Region* sensorRegion;
+    PhaseSpaceMessenger* messenger;
+};
+
+#endif /* PHASESPACEWRITER_HH_ */
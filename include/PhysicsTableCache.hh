@@ -0,0 +1,46 @@
+#ifndef PHYSICSTABLECACHE_HH_
+#define PHYSICSTABLECACHE_HH_
+
+#include "globals.hh"
+#include "G4VStateDependent.hh"
+
+class G4VUserPhysicsList;
+
+/*
+ * Cache of the built physics tables, shared by jobs with the same setup (pstep -c <dir>).
+ *
+ * Every time the kernel initializes a run, a key is hashed from the materials, the
+ * regions and their production cuts, the EM parameters and the processes attached to
+ * every particle. If <dir>/<key> exists, the tables are retrieved from it
+ * (/run/particle/retrievePhysicsTable). Otherwise they are built as usual and stored
+ * there once the run is initialized. The tables are written to a temporary directory
+ * that is renamed at the end, so concurrent jobs never read half-written tables.
+ * Geant4 falls back to building the tables if the stored cuts do not match.
+ *
+ * Only the tables the processes can store are cached (mostly the EM ones). The
+ * hadronic cross sections and the HP data are still initialized by every job.
+ *
+ * Created once, by main(), on the master. It watches the state of the master kernel.
+ */
+class PhysicsTableCache : public G4VStateDependent
+{
+public:
+    PhysicsTableCache( const G4String& dir, G4VUserPhysicsList* list );
+    virtual ~PhysicsTableCache();
+
+    // Idle -> Init: RunInitialization is about to build the tables, pick the key
+    // Idle -> GeomClosed: the tables are built, store them if the key was new
+    G4bool Notify( G4ApplicationState requestedState );
+
+private:
+    // 16 hex digits of the FNV-1a hash of the current setup
+    G4String ComputeKey() const;
+
+    G4String cacheDir;
+    G4VUserPhysicsList* physicsList;
+    // Directory the tables of the current run have to be stored to (empty: nothing to store)
+    G4String storeDir;
+    G4bool retrieved;
+};
+
+#endif /* PHYSICSTABLECACHE_HH_ */
@@ -7,17 +7,25 @@
 
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4GeneralParticleSource.hh"
+#include "EnergySpectrumSampler.hh"
 
+#include <cmath>
 #include <fstream>
 
 
 class G4VPrimaryGenerator;
+class PhaseSpaceGenerator;
+class FastSource;
+class PrimaryGeneratorMessenger;
  
 // This mandatory user class provides the primary particle generator
 //
 // Geant4 provides a number of predefined primary particle generator, to be utilised by the user.
 //  - G4ParticleGun
 //  - G4GeneralParticleSource
+// A phase-space file written at the converter/sensor boundary can be replayed instead of the GPS
+// The GPS directions of an isotropic source can be biased towards the detector stack
+//  - FastSource (G4ParticleGun based) for simple sources, selected with /det/gun/mode fast
 //
 // GeneratePrimaries()
 
@@ -30,12 +38,41 @@ public:
   ~PrimaryGeneratorAction();
   // defines primary particles (mandatory)
   void GeneratePrimaries(G4Event*);
+  // replay the phase-space file instead of the GPS ("none" goes back to the GPS)
+  void SetPhaseSpaceFile(const G4String& fileName);
+  G4bool IsReplayingPhaseSpace() const { return phaseSpaceGun != 0; }
+  // directional biasing of an isotropic GPS source: a fraction of the primaries is emitted
+  // into a cone around the axis, the vertex weight corrects for it (fraction 0 = off)
+  void SetDirectionBiasFraction(const G4double fraction) { biasFraction = fraction; }
+  void SetDirectionBiasAngle(const G4double angle) { biasCosAngle = std::cos(angle); }
+  void SetDirectionBiasAxis(const G4ThreeVector& axis);
+  // energy spectrum file sampled with an alias table instead of the GPS energy ("none" = GPS)
+  void SetEnergySpectrumFile(const G4String& fileName);
+  EnergySpectrumSampler* GetEnergySpectrum() { return &energySpectrum; }
+  // called at the start of each run: builds the alias table
+  void PrepareEnergySpectrum();
+  // called at the start of each run: the direction biasing needs an isotropic source
+  void CheckDirectionBias();
+  // GPS or FastSource
+  void SetFastSource(const G4bool fast) { useFastSource = fast; }
+  FastSource* GetFastSource() { return fastSource; }
     G4GeneralParticleSource * gps;
 private:  
   G4VPrimaryGenerator* InitializeGPS();
+  // re-sample the directions of the vertices [firstVertex, last] and weight them
+  void BiasDirections(G4Event* anEvent, G4int firstVertex);
 private:
   G4VPrimaryGenerator* gun;
+  PhaseSpaceGenerator* phaseSpaceGun;
+  FastSource* fastSource;
+  G4bool useFastSource;
+  G4double biasFraction;
+  G4double biasCosAngle;
+  G4ThreeVector biasAxis;
+  EnergySpectrumSampler energySpectrum;
+  G4bool useEnergySpectrum;
   std::ofstream * outfile;
+  PrimaryGeneratorMessenger* messenger;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
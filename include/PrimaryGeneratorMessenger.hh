@@ -0,0 +1,47 @@
+#ifndef PRIMARYGENERATORMESSENGER_HH_
+#define PRIMARYGENERATORMESSENGER_HH_
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class PrimaryGeneratorAction;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWith3Vector;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithAnInteger;
+
+class PrimaryGeneratorMessenger : public G4UImessenger
+{
+public:
+	// Constructor
+	PrimaryGeneratorMessenger(PrimaryGeneratorAction*);
+	// Destructor
+	virtual ~PrimaryGeneratorMessenger();
+	// handle user commands
+	void SetNewValue(G4UIcommand*,G4String);
+private:
+	PrimaryGeneratorAction*		action;
+
+	G4UIdirectory*				gunDir;
+	G4UIcmdWithAString*			replayPhaseSpaceCmd;
+	G4UIcmdWithADouble*			directionBiasCmd;
+	G4UIcmdWithADoubleAndUnit*	directionBiasAngleCmd;
+	G4UIcmdWith3Vector*			directionBiasAxisCmd;
+	G4UIcmdWithAString*			energySpectrumCmd;
+	G4UIcmdWithAString*			energySpectrumInterCmd;
+	G4UIcmdWithAnInteger*		energySpectrumBinsCmd;
+
+	G4UIcmdWithAString*			modeCmd;
+	G4UIdirectory*				fastDir;
+	G4UIcmdWith3VectorAndUnit*	fastCentreCmd;
+	G4UIcmdWith3Vector*			fastAxisCmd;
+	G4UIcmdWithADoubleAndUnit*	fastDiskRadiusCmd;
+	G4UIcmdWithAString*			fastAngleCmd;
+	G4UIcmdWithADoubleAndUnit*	fastBeamSigmaXCmd;
+	G4UIcmdWithADoubleAndUnit*	fastBeamSigmaYCmd;
+};
+
+#endif /* PRIMARYGENERATORMESSENGER_HH_ */
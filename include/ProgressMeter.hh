@@ -0,0 +1,49 @@
+#ifndef PROGRESSMETER_HH_
+#define PROGRESSMETER_HH_
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+#include <atomic>
+
+class G4UIdirectory;
+class G4UIcmdWithADoubleAndUnit;
+
+/*
+ * Progress report of the run, replacing the "Starting Event" line of every event.
+ * At most one line every /det/progress/interval (default 10 s, 0 switches it off):
+ * events done, events/s, ETA and fraction of the events with hits in the sensors.
+ *
+ * The counters are shared by all the threads (atomic, no lock per event). The clock is
+ * only read every few events and the lock only taken when a line is due. The object
+ * (and its UI command) exists only once, in the master (or sequential) RunAction.
+ */
+class ProgressMeter : public G4UImessenger
+{
+public:
+    ProgressMeter();
+    virtual ~ProgressMeter();
+    
+    void SetNewValue( G4UIcommand*, G4String );
+    
+    // Called by the master (or sequential) RunAction
+    static void BeginOfRun( G4int nEvents );
+    static void EndOfRun();
+    // Called by the EventAction of every thread
+    static void EventDone( G4bool hasHits );
+    
+private:
+    static void Print( G4double now );
+    
+    static G4double interval;       // seconds
+    static G4int nEventsToProcess;
+    static std::atomic<G4int> nEventsDone;
+    static std::atomic<G4int> nEventsWithHits;
+    static G4double startTime;
+    static std::atomic<G4double> lastPrintTime;
+    
+    G4UIdirectory* progressDir;
+    G4UIcmdWithADoubleAndUnit* intervalCmd;
+};
+
+#endif /* PROGRESSMETER_HH_ */
@@ -4,6 +4,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <TTree.h>
 #include "SiDigi.hh"
 #include "SiHit.hh"
@@ -12,6 +13,7 @@
 #include "SiHit_pix.hh"
 
 class TFile;
+class RootSaverMessenger;
 
 
 // Save hits and digits to a ROOT TTree.
@@ -42,38 +44,55 @@ public:
     
 	virtual void CreateTree_strip_det( const std::string& fileName = "s_tree",
                                        const std::string& treeName = "strip_tracker",
-                                       const int strips = 0);
+                                       const int strips = 0,
+                                       const int planes = 3);
     
     virtual void CreateTree_pixel_det( const std::string& fileName = "p_tree",
                                        const std::string& treeName = "pixel_tracker",
-                                       const int pixels = 0);
+                                       const int pixels = 0,
+                                       const int planes = 4);
 	
     // Close the file and save ROOT TTree
     // The ROOT file should be closed at the end of each /run/beamOn
 	virtual void CloseTrees();
     
-	// Add hits and digi container for this event
+	// Add hits and digi container for this event, hits[plane] is the hits collection
+	// of each plane (0 if missing)
 	virtual void AddEvent_strip_det(const G4int event,
-                                    const SiHitCollection * const hits_x1,
-                                    const SiHitCollection * const hits_u1,
-                                    const SiHitCollection * const hits_v1,
+                                    const std::vector<const SiHitCollection*>& hits,
                                     const SiDigiCollection * const digits,
                                     const G4ThreeVector& primaryPos,
                                     const G4ThreeVector& primaryMom,
 
-                                    const G4float KE_in);
+                                    const G4float KE_in,
+                                    const G4float eventWeight = 1);
     
     // Add hits and digi container for this event
     virtual void AddEvent_pixel_det(const G4int event,
-                                    const SiHit_pixCollection * const hits_pix1,
-                                    const SiHit_pixCollection * const hits_pix2,
-                                    const SiHit_pixCollection * const hits_pix3,
-                                    const SiHit_pixCollection * const hits_pix4,
+                                    const std::vector<const SiHit_pixCollection*>& hits,
                                     const SiDigi_pixCollection * const digits,
                                     const G4ThreeVector& primaryPos,
                                     const G4ThreeVector& primaryMom,
 
-                                    const G4float KE_in);
+                                    const G4float KE_in,
+                                    const G4float eventWeight = 1);
+    
+    // Store the signal as (channel, charge) vectors of the channels above threshold
+    // instead of a dense array holding every strip/pixel (takes effect at the next run)
+    void SetSparseSignal( const G4bool& flag )           { sparseSignal = flag; }
+    void SetSignalThreshold( const G4double& aValue )    { signalThreshold = aValue; }
+    
+    // Only fill the trees with events that have hits, and whose largest channel charge
+    // reaches eventChargeThreshold (e-). The events seen are counted in the run_info tree.
+    void SetSkipEmptyEvents( const G4bool& flag )        { skipEmptyEvents = flag; }
+    void SetEventChargeThreshold( const G4double& aValue ) { eventChargeThreshold = aValue; }
+    
+    // Merge the per-thread files of a multithreaded run into outFile, input files are deleted
+    static G4bool MergeFiles( const std::vector<std::string>& inFiles, const std::string& outFile );
+    
+    // Name of the last file opened for each tree
+    const std::string & Get_file_name_strip() const {return fileName_strip;}
+    const std::string & Get_file_name_pixel() const {return fileName_pixel;}
     
     TTree * Get_root_tree_strip(){return rootTree_strip;}
     TTree * Get_root_tree_pixel(){return rootTree_pixel;}
@@ -81,12 +100,39 @@ public:
     
 private:
     
+    // Write the run_info tree (one entry: events generated/written, sum of event weights) to file
+    void WriteRunInfo( TFile * file, const Long64_t nGenerated, const Long64_t nWritten, const Double_t sumWeights );
+    
+    // Particle and process names are written as integer codes, a stable hash of the name, so that the
+    // codes agree between the files of all threads and jobs. The name_dict tree of each file lists
+    // the (code, name) pairs used in it.
+    typedef std::map<Int_t, std::string> NameDictionary;
+    Int_t NameCode( const G4String& name, NameDictionary & dictionary );
+    void WriteNameDictionary( TFile * file, const NameDictionary & dictionary );
+    
 	TTree * rootTree_strip;            // Pointer to the ROOT TTree for strip data
 	TTree * rootTree_pixel;            // Pointer to the ROOT TTree for pixel data
     TFile * rootFile;                   // Pointer to the ROOT TFile
+    std::string fileName_strip;         // Name of the file holding the strip TTree
+    std::string fileName_pixel;         // Name of the file holding the pixel TTree
 	unsigned int runCounter;            // Run counter to uniquely identify ROOT file
 	Int_t nStrips;                      // Number of strips in each det. plane
     Int_t nPixels;                      // Number of pixels in each det. plane
+    Int_t nStripPlanes;                 // Number of strip det. planes
+    Int_t nPixelPlanes;                 // Number of pixel det. planes
+    G4bool sparseSignal;                // Write sparse (channel, charge) signal vectors instead of dense arrays
+    G4double signalThreshold;           // Min. charge (e-) for a channel to be written in sparse mode
+    G4bool skipEmptyEvents;             // Do not fill the trees with events without hits / charge
+    G4double eventChargeThreshold;      // Min. charge (e-) of the largest channel for an event to be written
+    RootSaverMessenger * messenger;     // UI commands (/det/output/)
+    
+    // Run counters for the run_info tree, needed to normalise when empty events are skipped
+    Long64_t nEventsGenerated_strip;
+    Long64_t nEventsWritten_strip;
+    Double_t sumEventWeight_strip;
+    Long64_t nEventsGenerated_pixel;
+    Long64_t nEventsWritten_pixel;
+    Double_t sumEventWeight_pixel;
     
 	//*** TTree variables ***//
     
@@ -101,181 +147,82 @@ private:
     
     // Kinetic Energy of primary at origin
     Float_t KE_in;
+    // Weight of the primary vertex (source biasing), 1 for an unbiased source
+    Float_t Event_weight;
     
-    
-    // STRIP DETECTOR VARIABLES
-    
-    // Hit multiplicity for det. (no. of tracks (particles) / det. / event )
-    Int_t Hit_mult_x1;
-    Int_t Hit_mult_u1;
-    Int_t Hit_mult_v1;
-
-    // Signal in electrons for each strip on each det.
-	Float_t* Signal_x1;
-    Float_t* Signal_u1;
-    Float_t* Signal_v1;
-    
-    // strips fired / det. / event
-	std::vector<Int_t> Strip_no_x1;
-    std::vector<Int_t> Strip_no_u1;
-    std::vector<Int_t> Strip_no_v1;
-    
-    // total no. of strips fired / det. / event
-    Int_t ClusterSize_x1;
-    Int_t ClusterSize_u1;
-    Int_t ClusterSize_v1;
-    
-    // total no. of det. fired / event
+    // total no. of strip det. fired / event
     Int_t Det_mult;
     
-    // non ionising edep stored for x1 only for use in dose calcs
-    std::vector<Double_t> NI_Edep_x1;
-    
-    // Sum of edep (MeV) in det.
-	std::vector<Double_t> Edep_x1;
-	std::vector<Double_t> Edep_u1;
-	std::vector<Double_t> Edep_v1;
-    
-    // Polar angle in the xz plane (measured from z-axis)
-    std::vector<Double_t> Theta_x1;
-    std::vector<Double_t> Theta_u1;
-    std::vector<Double_t> Theta_v1;
-    
-    // x position of particle in det. (must be double as float/Float_t dont work! (bug))
-	std::vector<Double_t> X_pos_x1;
-	std::vector<Double_t> X_pos_u1;
-	std::vector<Double_t> X_pos_v1;
-    
-    // y position of particle in det. (must be double as float/Float_t dont work! (bug))
-	std::vector<Double_t> Y_pos_x1;
-	std::vector<Double_t> Y_pos_u1;
-	std::vector<Double_t> Y_pos_v1;
-    
-    // z position of particle in det. (must be double as float/Float_t dont work! (bug))
-	std::vector<Double_t> Z_pos_x1;
-	std::vector<Double_t> Z_pos_u1;
-	std::vector<Double_t> Z_pos_v1;
-    
-    // Does hit in det. contain primary event?
-    std::vector<Bool_t> IsPrimaryParticle_x1;
-    std::vector<Bool_t> IsPrimaryParticle_u1;
-    std::vector<Bool_t> IsPrimaryParticle_v1;
-    
-    // Particle track no. (for counting number of particles / det. / event)
-    std::vector<Int_t> Track_no_x1;
-    std::vector<Int_t> Track_no_u1;
-    std::vector<Int_t> Track_no_v1;
-    
-    // Particle name / det. / event (must be TString otherwise won't work),
-    // At command line use e.g. tv__tree->Draw("hit_mult_x1","ParticleName_x1==\"e-\""); to select as condition
-    std::vector<TString> ParticleName_x1;
-    std::vector<TString> ParticleName_u1;
-    std::vector<TString> ParticleName_v1;
-    
-    
-    // PIXEL DETECTOR VARIABLES
-    
-    // Hit multiplicity for det. (no. of tracks (particles) / det. / event )
-    Int_t Hit_mult_pix1;
-    Int_t Hit_mult_pix2;
-    Int_t Hit_mult_pix3;
-    Int_t Hit_mult_pix4;
-    
-    // Signal in electrons for each strip on each det.
-    Float_t * Signal_pix1;
-    Float_t * Signal_pix2;
-    Float_t * Signal_pix3;
-    Float_t * Signal_pix4;
-    
-    // non ionising edep stored for x1 only for use in dose calcs
-    std::vector<Double_t> NI_Edep_pix1;
-    std::vector<Double_t> NI_Edep_pix2;
-    std::vector<Double_t> NI_Edep_pix3;
-    std::vector<Double_t> NI_Edep_pix4;
-    
-    // Sum of edep (MeV) in det.
-    std::vector<Double_t> Edep_pix1;
-    std::vector<Double_t> Edep_pix2;
-    std::vector<Double_t> Edep_pix3;
-    std::vector<Double_t> Edep_pix4;
-
-  //***************************Welcome new histogram the Kinetic Energy ;)*******************************************************
-
-  // Sum of Kinetic Energy (MeV) in det.
-    std::vector<Double_t> Truth_KE_pix1;
-    std::vector<Double_t> Truth_KE_pix2;
-    std::vector<Double_t> Truth_KE_pix3;
-    std::vector<Double_t> Truth_KE_pix4;
-  //********************************************************************************
-
-    // x position of particle in det. (must be double as float/Float_t dont work! (bug))
-    std::vector<Double_t> X_pos_pix1;
-    std::vector<Double_t> X_pos_pix2;
-    std::vector<Double_t> X_pos_pix3;
-    std::vector<Double_t> X_pos_pix4;
-    
-    // y position of particle in det. (must be double as float/Float_t dont work! (bug))
-    std::vector<Double_t> Y_pos_pix1;
-    std::vector<Double_t> Y_pos_pix2;
-    std::vector<Double_t> Y_pos_pix3;
-    std::vector<Double_t> Y_pos_pix4;
-    
-    // z position of particle in det. (must be double as float/Float_t dont work! (bug))
-    std::vector<Double_t> Z_pos_pix1;
-    std::vector<Double_t> Z_pos_pix2;
-    std::vector<Double_t> Z_pos_pix3;
-    std::vector<Double_t> Z_pos_pix4;
-  //*******************************************************************************************************************************
-    // x Truth position of particle in det. (must be double as float/Float_t dont work! (bug))
-    std::vector<Double_t> Truth_X_pos_pix1;
-    std::vector<Double_t> Truth_X_pos_pix2;
-    std::vector<Double_t> Truth_X_pos_pix3;
-    std::vector<Double_t> Truth_X_pos_pix4;
-    
-    // y Truth position of particle in det. (must be double as float/Float_t dont work! (bug))
-    std::vector<Double_t> Truth_Y_pos_pix1;
-    std::vector<Double_t> Truth_Y_pos_pix2;
-    std::vector<Double_t> Truth_Y_pos_pix3;
-    std::vector<Double_t> Truth_Y_pos_pix4;
-    
-    // z Truth position of particle in det. (must be double as float/Float_t dont work! (bug))
-    std::vector<Double_t> Truth_Z_pos_pix1;
-    std::vector<Double_t> Truth_Z_pos_pix2;
-    std::vector<Double_t> Truth_Z_pos_pix3;
-    std::vector<Double_t> Truth_Z_pos_pix4;
- 
-
-  //*******************************************************************************************************************************
-    // Does hit in det. contain primary event?
-    std::vector<Bool_t> IsPrimaryParticle_pix1;
-    std::vector<Bool_t> IsPrimaryParticle_pix2;
-    std::vector<Bool_t> IsPrimaryParticle_pix3;
-    std::vector<Bool_t> IsPrimaryParticle_pix4;
-    
-    // Particle track no. (for counting number of particles / det. / event)
-    std::vector<Int_t> Track_no_pix1;
-    std::vector<Int_t> Track_no_pix2;
-    std::vector<Int_t> Track_no_pix3;
-    std::vector<Int_t> Track_no_pix4;
-    
-    // Particle name / det. / event (must be TString otherwise won't work),
-    // At command line use e.g. tv__tree->Draw("hit_mult_x1","ParticleName_x1==\"e-\""); to select as condition
-    std::vector<TString> ParticleName_pix1;
-    std::vector<TString> ParticleName_pix2;
-    std::vector<TString> ParticleName_pix3;
-    std::vector<TString> ParticleName_pix4;
-
-
-  //********************************************************************
-  //  std::vector<TString> ParticleParent_pix1;
-  // std::vector<TString> ParticleParent_pix2;
-  //  std::vector<TString> ParticleParent_pix3;
-  //  std::vector<TString> ParticleParent_pix4;
-
-   std::vector<TString> ProcessName_pix1;
-   std::vector<TString> ProcessName_pix2;
-    std::vector<TString> ProcessName_pix3;
-    std::vector<TString> ProcessName_pix4;
+    /* Variables of one detector plane (x1,u1,v1,... or pix1,pix2,...).
+     *
+     * One element of each vector per track (particle) crossing the plane, element [0] = first track.
+     * The branches are named <variable>_<plane name>, see DetectorPlanes.
+     */
+    struct PlaneData
+    {
+        // Clear the per event variables, the vectors keep their capacity from one event to the next
+        void Clear();
+        // Reserve room for nTracks tracks in every vector
+        void Reserve( const size_t nTracks );
+        
+        // Hit multiplicity for det. (no. of tracks (particles) / det. / event )
+        Int_t Hit_mult;
+        // total no. of strips fired / det. / event (strip planes only)
+        Int_t ClusterSize;
+        
+        // Sparse signal: channel no. and signal in electrons of the channels above threshold
+        std::vector<Int_t> Signal_channel;
+        std::vector<Float_t> Signal_charge;
+        // strips fired / det. / event (strip planes only)
+        std::vector<Int_t> Strip_no;
+        
+        // non ionising edep (use for dose calcs), only written for x1 on the strip tree
+        std::vector<Double_t> NI_Edep;
+        // Sum of edep (MeV) in det.
+        std::vector<Double_t> Edep;
+        // Kinetic Energy (MeV) of the particle in det. (pixel planes only)
+        std::vector<Double_t> Truth_KE;
+        // Statistical weight of the track (importance biasing), 1 for unbiased runs (pixel planes only)
+        std::vector<Double_t> Weight;
+        // Polar angle in the xz plane (measured from z-axis), strip planes only, not written
+        std::vector<Double_t> Theta;
+        
+        // Position of particle in det. (must be double as float/Float_t dont work! (bug))
+        std::vector<Double_t> X_pos;
+        std::vector<Double_t> Y_pos;
+        std::vector<Double_t> Z_pos;
+        // Truth position of particle in det. (pixel planes only)
+        std::vector<Double_t> Truth_X_pos;
+        std::vector<Double_t> Truth_Y_pos;
+        std::vector<Double_t> Truth_Z_pos;
+        
+        // Does hit in det. contain primary event?
+        std::vector<Bool_t> IsPrimaryParticle;
+        // Particle track no. (for counting number of particles / det. / event)
+        std::vector<Int_t> Track_no;
+        // Particle name code / det. / event, see name_dict. At command line use e.g.
+        // tv__tree->Draw("hit_mult_x1","particleCode_x1==<code of e- in name_dict>"); to select as condition
+        std::vector<Int_t> ParticleCode;
+        // Creator process code (pixel planes only)
+        std::vector<Int_t> ProcessCode;
+    };
+    
+    // Fill the hit variables of one plane from its hits collection
+    void FillStripPlane( PlaneData & plane, const SiHitCollection * const hits, const G4ThreeVector& primPos );
+    void FillPixelPlane( PlaneData & plane, const SiHit_pixCollection * const hits );
+    
+    // One element per plane, sized when the tree is created: the branches point into them
+    std::vector<PlaneData> stripPlanes;
+    std::vector<PlaneData> pixelPlanes;
+    
+    // Dense signal in electrons of every strip/pixel (only with sparseSignal false),
+    // all the planes in one contiguous buffer, plane p starts at p*nStrips (p*nPixels)
+    std::vector<Float_t> Signal_strip;
+    std::vector<Float_t> Signal_pixel;
+    
+    // Names coded in the strip/pixel file of the current run
+    NameDictionary nameDictionary_strip;
+    NameDictionary nameDictionary_pixel;
     
 };
 
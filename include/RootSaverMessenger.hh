@@ -0,0 +1,31 @@
+#ifndef ROOTSAVERMESSENGER_HH_
+#define ROOTSAVERMESSENGER_HH_
+
+#include "globals.hh"
+#include "G4UImessenger.hh"
+
+class RootSaver;
+class G4UIdirectory;
+class G4UIcmdWithADouble;
+class G4UIcmdWithABool;
+
+class RootSaverMessenger : public G4UImessenger
+{
+public:
+	// Constructor
+	RootSaverMessenger(RootSaver*);
+	// Destructor
+	virtual ~RootSaverMessenger();
+	// handle user commands
+	void SetNewValue(G4UIcommand*,G4String);
+private:
+	RootSaver*					saver;
+
+	G4UIdirectory*				outputDir;
+	G4UIcmdWithABool*			sparseSignalCmd;
+	G4UIcmdWithADouble*			signalThresholdCmd;
+	G4UIcmdWithABool*			skipEmptyEventsCmd;
+	G4UIcmdWithADouble*			eventChargeThresholdCmd;
+};
+
+#endif /* ROOTSAVERMESSENGER_HH_ */
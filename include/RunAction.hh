@@ -4,11 +4,17 @@
 
 #include "G4UserRunAction.hh"
 #include "RootSaver.hh"
+#include "PhaseSpaceWriter.hh"
+
+#include <ctime>
+#include <string>
+#include <vector>
 
 class G4Run;
 class EventAction;
 class DetectorConstruction;
 class PrimaryGeneratorAction;
+class ProgressMeter;
 //class G4VUserPrimaryGeneratorAction;
 
 /*
@@ -17,6 +23,8 @@ class PrimaryGeneratorAction;
  * The relevant method is BeginOfRunAction and EndOfRunAction
  * This class controls the saving facility (RootSaver class), since
  * the handling of ROOT TTree is done at run level (each run one TTree)
+ * In MT mode each worker fills its own RootSaver (no locking per event)
+ * and the master merges the worker files at the end of the run.
  */
 class RunAction : public G4UserRunAction
 {
@@ -24,20 +32,35 @@ public:
 	// constructor
 	RunAction( /*G4VUser*/PrimaryGeneratorAction * pgAct, EventAction* evAct, DetectorConstruction* myDet );
 	// destructor
-	virtual ~RunAction() {};
+	virtual ~RunAction();
 	// Called at the beginning of each run
 	void BeginOfRunAction(const G4Run*);
 	// Called at the end of each run
 	void EndOfRunAction(const G4Run*);
+	// Phase-space writer filled by the SteppingAction
+	PhaseSpaceWriter* GetPhaseSpaceWriter() { return &phaseSpace; }
 private:
 	// The ROOT TTree handler object
 	RootSaver saver;
+	// Phase-space file at the converter/sensor boundary (off unless /det/phaseSpace/record is set)
+	PhaseSpaceWriter phaseSpace;
+	// Progress report (UI command), only in the master or sequential run action
+	ProgressMeter* progress;
     // Pointer to the PrimaryGeneratorAction
     /*G4VUser*/PrimaryGeneratorAction * primGenAction;
 	// Pointer to the EventAction
 	EventAction* eventAction;
     // Pointer to the DetectorConstruction
     DetectorConstruction* myDetector;
+    
+    // Unique ID used in the output file names. Set by the master (or sequential)
+    // run action so that all the worker files of one run share the same ID
+    static time_t runUID;
+    // Files written by the worker threads during the current run,
+    // merged into a single file by the master run action at the end of the run
+    static std::vector<std::string> workerFiles_strip;
+    static std::vector<std::string> workerFiles_pixel;
+    static std::vector<std::string> workerFiles_phsp;
 };
 
 #endif /* RUNACTION_HH_ */
@@ -3,6 +3,8 @@
 #define SensitiveDetector_pix_h 1
 
 #include "G4VSensitiveDetector.hh"
+#include <map>
+#include <utility>
 class DetectorConstruction;
 class RunAction;
 
@@ -16,7 +18,8 @@ class G4HCofThisEvent;           // <<- means "H(it) C(ollections) of This Event
  * Stores Hits with 
  *  * deposited energy
  *  * position
- * in <i>Hit Collections of This Event</i>
+ * in <i>Hit Collections of This Event</i>,
+ * one hit per track and pixel (steps are accumulated)
  *
  * ProcessHits()
  */
@@ -41,6 +44,8 @@ public:
 
 private:
   SiHit_pixCollection*      hitCollection;
+  // hit of this event for each (track ID, pixel copy no.), used to accumulate the steps
+  std::map< std::pair<G4int,G4int>, SiHit_pix* > hitMap;
   G4int                 HCID;       //JT
 };
 
@@ -104,7 +104,7 @@ typedef G4TDigiCollection<SiDigi> SiDigiCollection;
  * Operators new and delete for the SiDigi objects have to be
  * defined
  */
-extern G4Allocator<SiDigi> SiDigiAllocator;
+extern G4ThreadLocal G4Allocator<SiDigi>* SiDigiAllocator;
 
 //It's not very nice to have these two in .hh and not in .cc
 //But if we move these to the correct place we receive a warning at compilation time
@@ -112,12 +112,13 @@ extern G4Allocator<SiDigi> SiDigiAllocator;
 //This should be cleaned somehow...
 void* SiDigi::operator new(size_t)
 {
-  return static_cast<void*>( SiDigiAllocator.MallocSingle() );
+  if ( !SiDigiAllocator ) {SiDigiAllocator = new G4Allocator<SiDigi>;}
+  return static_cast<void*>( SiDigiAllocator->MallocSingle() );
 }
 
 void SiDigi::operator delete(void* aDigi)
 {
-  SiDigiAllocator.FreeSingle( static_cast<SiDigi*>(aDigi) );
+  SiDigiAllocator->FreeSingle( static_cast<SiDigi*>(aDigi) );
 }
 
 #endif /* SIDIGI_HH_ */
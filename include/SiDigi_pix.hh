@@ -87,7 +87,7 @@ typedef G4TDigiCollection<SiDigi_pix> SiDigi_pixCollection;
 // Allocator
 // Creating this objects allows for an efficient use of memory.
 // Operators new and delete for the SiDigi objects have to be defined
-extern G4Allocator<SiDigi_pix> SiDigi_pixAllocator;
+extern G4ThreadLocal G4Allocator<SiDigi_pix>* SiDigi_pixAllocator;
 
 // It's not very nice to have these two in .hh and not in .cc
 // But if we move these to the correct place we receive a warning at compilation time
@@ -95,12 +95,13 @@ extern G4Allocator<SiDigi_pix> SiDigi_pixAllocator;
 // This should be cleaned somehow...
 void * SiDigi_pix::operator new(size_t)
 {
-  return static_cast<void*>( SiDigi_pixAllocator.MallocSingle() );
+  if ( !SiDigi_pixAllocator ) {SiDigi_pixAllocator = new G4Allocator<SiDigi_pix>;}
+  return static_cast<void*>( SiDigi_pixAllocator->MallocSingle() );
 }
 
 void SiDigi_pix::operator delete(void* aDigi)
 {
-  SiDigi_pixAllocator.FreeSingle( static_cast<SiDigi_pix*>(aDigi) );
+  SiDigi_pixAllocator->FreeSingle( static_cast<SiDigi_pix*>(aDigi) );
 }
 
 #endif /* SIDIGI_PIX_HH_ */
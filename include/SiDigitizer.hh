@@ -5,6 +5,7 @@
 
 #include "G4VDigitizerModule.hh"
 #include "SiDigi.hh"
+#include "G4ThreeVector.hh"
 #include "NoiseGenerator.hh"
 #include "MeV2ChargeConverter.hh"
 #include "CrosstalkGenerator.hh"
@@ -13,6 +14,9 @@
 #include "DiffusionGenerator.hh"
 #include "TrackerGeometry.hh"
 
+#include <vector>
+#include <utility>
+
 /*
  Simulation of the digitization process
  This class is responsible for the simulation of the ditis i.e.
@@ -68,7 +72,27 @@ protected:
    * is added. Digitize
    */
   //virtual void MakeCrosstalk(std::vector< std::vector< SiDigi* > >& digitsMap);
-   virtual void MakeDiffusion(std::vector< std::vector< SiDigi* > >& digitsMap );
+  /* Simulate the charge diffusion (sharing) between strips
+   *
+   * Only the strips in hitStrips, the (plane,strip) pairs that received a hit,
+   * sorted by plane and strip, are used as seeds: the cost scales with the
+   * number of hits, not with the number of strips.
+   */
+   virtual void MakeDiffusion(std::vector< std::vector< SiDigi* > >& digitsMap,
+                              const std::vector< std::pair< G4int, G4int > >& hitStrips );
+
+  /* Sparse digitization helpers
+   *
+   * GetDigi returns the digit of (plane,strip), creating it and inserting
+   * it in the collection the first time the strip is touched.
+   * AddNoiseDigits draws the number of noise-only strips above noiseThreshold
+   * from a binomial with the gaussian tail probability, and creates just those
+   * digits, instead of smearing every strip of every plane.
+   */
+  SiDigi* GetDigi(SiDigiCollection* digiCollection, std::vector< std::vector< SiDigi* > >& digitsMap,
+                  G4int plane, G4int strip, std::vector< G4int >& nDigits);
+  void AddNoiseDigits(SiDigiCollection* digiCollection, std::vector< std::vector< SiDigi* > >& digitsMap,
+                      std::vector< G4int >& nDigits);
 
 public:
   // some simple set & get functions
@@ -78,34 +102,14 @@ public:
   inline void     SetPedestal( const G4double& aValue )         { pedestal = aValue; }
   inline void	  SetNoise( const G4double& aValue )            { noise = NoiseGenerator(aValue); }
   //inline void	  SetCrosstalk( const G4double& aValue )        { crosstalk = CrosstalkGenerator(aValue,1024); }
-  inline void	  SetDiffusion( const G4double& aValue )        { diffusion = DiffusionGenerator(aValue); }
+  inline void	  SetDiffusion( const G4double& aValue )        { diffusionBias = aValue; diffusion = DiffusionGenerator(aValue, tracker.get_thickness()); }
     
   inline void	  SetConversionFactor( const G4double& aValue ) { convert = MeV2ChargeConverter(aValue); }
   inline void     SetCollectionName( const G4String& aName )    { digiCollectionName = aName; }
     
-  inline void     SetHitsCollectionName_x1( const G4String& aName ){ hitsCollName_x1 = aName; }
-  inline void     SetHitsCollectionName_u1( const G4String& aName ){ hitsCollName_u1 = aName; }
-  inline void     SetHitsCollectionName_v1( const G4String& aName ){ hitsCollName_v1 = aName; }
-    
-  inline void     SetHitsCollectionName_x2( const G4String& aName ){ hitsCollName_x2 = aName; }
-  inline void     SetHitsCollectionName_u2( const G4String& aName ){ hitsCollName_u2 = aName; }
-  inline void     SetHitsCollectionName_v2( const G4String& aName ){ hitsCollName_v2 = aName; }
-    
-  inline void     SetHitsCollectionName_TP1( const G4String& aName ){ hitsCollName_TP1 = aName; }
-  inline void     SetHitsCollectionName_TP2( const G4String& aName ){ hitsCollName_TP2 = aName; }
-    
-  inline void     SetHitsCollectionName_TP3( const G4String& aName ){ hitsCollName_TP3 = aName; }
-  inline void     SetHitsCollectionName_TP4( const G4String& aName ){ hitsCollName_TP4 = aName; }
-    
-  inline void     SetHitsCollectionName_x3( const G4String& aName ){ hitsCollName_x3 = aName; }
-  inline void     SetHitsCollectionName_u3( const G4String& aName ){ hitsCollName_u3 = aName; }
-  inline void     SetHitsCollectionName_v3( const G4String& aName ){ hitsCollName_v3 = aName; }
-
-  inline void     SetHitsCollectionName_x4( const G4String& aName ){ hitsCollName_x4 = aName; }
-  inline void     SetHitsCollectionName_u4( const G4String& aName ){ hitsCollName_u4 = aName; }
-  inline void     SetHitsCollectionName_v4( const G4String& aName ){ hitsCollName_v4 = aName; }
-    
-  inline void     SetHitsCollectionName_TP5( const G4String& aName ){ hitsCollName_TP5 = aName; }
+  // Sparse mode: only strips with charge (plus statistically drawn noise hits) get a digit
+  inline void     SetSparseDigitization( const G4bool& flag )   { sparseDigitization = flag; }
+  inline void     SetNoiseThreshold( const G4double& aValue )   { noiseThreshold = aValue; }
     
   //Used for re-setting the no. of planes and strips in case they have been changed from the default
   //vaules set in DetectorConstruction.cc by the .mac file. Necessary because DetectorConsturcion object with
@@ -114,36 +118,18 @@ public:
   //This then creates an error if the .mac file alters these parameters and recompiles the DetectorConstruction object.
   inline void     ReSetDigiCollectionStrips( const G4int& aValue ){ digiCollectionStrips = aValue; }
   inline void     ReSetDigiCollectionPlanes( const G4int& aValue ){ digiCollectionPlanes = aValue; }
+  //Same for the strip sensor geometry used by the charge diffusion: the geometry (and the diffusion,
+  //which depends on the thickness) are only rebuilt when one of the values has changed. The planes
+  //0..positions.size()-1 are moved to their world centre and stereo angle in the simulation
+  void            ReSetSensorGeometry( const G4int& nStrips, const G4double& pitch, const G4double& length, const G4double& thickness,
+                                       const std::vector<G4ThreeVector>& positions, const std::vector<G4double>& angles );
 
 private:
     
   //Name of the digits collection
   G4String digiCollectionName;
 
-  //Name of the hits collection. Should match what has been used in SensitiveDetector
-  G4String hitsCollName_x1;
-  G4String hitsCollName_u1;
-  G4String hitsCollName_v1;
-    
-  G4String hitsCollName_x2;
-  G4String hitsCollName_u2;
-  G4String hitsCollName_v2;
- 
-  G4String hitsCollName_TP1;
-  G4String hitsCollName_TP2;
-    
-  G4String hitsCollName_TP3;
-  G4String hitsCollName_TP4;
-    
-  G4String hitsCollName_x3;
-  G4String hitsCollName_u3;
-  G4String hitsCollName_v3;
-    
-  G4String hitsCollName_x4;
-  G4String hitsCollName_u4;
-  G4String hitsCollName_v4;
-    
-  G4String hitsCollName_TP5;
+  //The hits collections are named after the planes, see DetectorPlanes
 
   G4int digiCollectionStrips;
   G4int digiCollectionPlanes;    
@@ -154,6 +140,12 @@ private:
   //The object responsible to generate the electronic noise
   NoiseGenerator noise;
     
+  //Create digits only for strips with charge
+  G4bool sparseDigitization;
+    
+  //Level (in elementary charge units, pedestal included) a noise-only strip must exceed to get a digit in sparse mode
+  G4double noiseThreshold;
+    
   //The object that converts the energy deposit in collected charge
   MeV2ChargeConverter convert;
     
@@ -163,9 +155,15 @@ private:
   //The object that handles the charge diffusion
   //And is used by the MakeDiffusion() function.
   DiffusionGenerator diffusion;
+  //Bias voltage of the charge diffusion, kept to rebuild it when the thickness changes
+  G4double diffusionBias;
   //The object that handles the tracker geometry used in charge diffusion
-  //And is used by the MakeDiffusion() function.
+  //And is used by the MakeDiffusion() function. Built from the DetectorConstruction parameters
+  //by ReSetSensorGeometry(), never from tracker_geom.mac
   TrackerGeometry tracker;
+  //Plane placement the geometry was built with
+  std::vector<G4ThreeVector> planePositions;
+  std::vector<G4double> planeAngles;
 
   //Messenger to implement some UI commands
   //SiDigitizerMessenger messenger;
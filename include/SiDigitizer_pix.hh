@@ -71,6 +71,19 @@ protected:
   //virtual void MakeCrosstalk(std::vector< std::vector< SiDigi* > >& digitsMap);
    //virtual void MakeDiffusion(std::vector< std::vector< SiDigi_pix* > >& digitsMap );
     
+  /* Sparse digitization helpers
+   *
+   * GetDigi returns the digit of (plane,pixel), creating it and inserting
+   * it in the collection the first time the pixel is touched.
+   * AddNoiseDigits draws the number of noise-only pixels above noiseThreshold
+   * from a binomial with the gaussian tail probability, and creates just those
+   * digits, instead of smearing every pixel of every plane.
+   */
+  SiDigi_pix* GetDigi(SiDigi_pixCollection* digiCollection, std::vector< std::vector< SiDigi_pix* > >& digitsMap,
+                      G4int plane, G4int pixel, std::vector< G4int >& nDigits);
+  void AddNoiseDigits(SiDigi_pixCollection* digiCollection, std::vector< std::vector< SiDigi_pix* > >& digitsMap,
+                      std::vector< G4int >& nDigits);
+    
 public:
   // some simple set & get functions
   //
@@ -85,10 +98,9 @@ public:
   inline void	  SetConversionFactor( const G4double& aValue ) { convert = MeV2ChargeConverter(aValue); }
   inline void     SetCollectionName( const G4String& aName )    { digiCollectionName = aName; }
     
-  inline void     SetHitsCollectionName_pix1( const G4String& aName ){ hitsCollName_pix1 = aName; }
-  inline void     SetHitsCollectionName_pix2( const G4String& aName ){ hitsCollName_pix2 = aName; }
-  inline void     SetHitsCollectionName_pix3( const G4String& aName ){ hitsCollName_pix3 = aName; }
-  inline void     SetHitsCollectionName_pix4( const G4String& aName ){ hitsCollName_pix4 = aName; }
+  // Sparse mode: only pixels with charge (plus statistically drawn noise hits) get a digit
+  inline void     SetSparseDigitization( const G4bool& flag )   { sparseDigitization = flag; }
+  inline void     SetNoiseThreshold( const G4double& aValue )   { noiseThreshold = aValue; }
     
   //Used for re-setting the no. of planes and strips in case they have been changed from the default
   //vaules set in DetectorConstruction.cc by the .mac file. Necessary because DetectorConsturcion object with
@@ -103,11 +115,7 @@ private:
   //Name of the digits collection
   G4String digiCollectionName;
     
-  //Name of the hits collection. Should match what has been used in SensitiveDetector
-  G4String hitsCollName_pix1;
-  G4String hitsCollName_pix2;
-  G4String hitsCollName_pix3;
-  G4String hitsCollName_pix4;
+  //The hits collections, one per plane, are named by DetectorPlanes like the SDs
 
   G4int digiCollectionPixels;
   G4int digiCollectionPlanes;
@@ -118,6 +126,12 @@ private:
   //The object responsible to generate the electronic noise
   NoiseGenerator noise;
     
+  //Create digits only for pixels with charge
+  G4bool sparseDigitization;
+    
+  //Level (in elementary charge units, pedestal included) a noise-only pixel must exceed to get a digit in sparse mode
+  G4double noiseThreshold;
+    
   //The object that converts the energy deposit in collected charge
   MeV2ChargeConverter convert;
     
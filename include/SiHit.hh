@@ -56,7 +56,7 @@ public:
   G4int         GetPlaneNumber()       const  { return planeNumber; }
   G4int         GetTrackNumber()       const  { return trackNumber; }
   G4bool	    GetIsPrimary()         const  { return isPrimary; }
-  G4String      GetParticleName()      const  { return ParticleName; }
+  const G4String& GetParticleName()    const  { return ParticleName; }
 //G4String      GetProcessName()       const  { return ProcessName; }
     
 private:
@@ -77,17 +77,18 @@ typedef G4THitsCollection<SiHit> SiHitCollection;
 
 
 // -- new and delete overloaded operators:
-extern G4Allocator<SiHit> SiHitAllocator;
+extern G4ThreadLocal G4Allocator<SiHit>* SiHitAllocator;
 
 inline void* SiHit::operator new(size_t)
 {
   void *aHit;
-  aHit = (void *) SiHitAllocator.MallocSingle();
+  if ( !SiHitAllocator ) {SiHitAllocator = new G4Allocator<SiHit>;}
+  aHit = (void *) SiHitAllocator->MallocSingle();
   return aHit;
 }
 inline void SiHit::operator delete(void *aHit)
 {
-  SiHitAllocator.FreeSingle((SiHit*) aHit);
+  SiHitAllocator->FreeSingle((SiHit*) aHit);
 }
 
 #endif
@@ -21,6 +21,7 @@
  *  - PIXEL and plane number
  *  - deposited energy
  *  - position information
+ *  - statistical weight of the track
  */
 
 class SiHit_pix : public G4VHit {
@@ -47,12 +48,13 @@ public:
   void          SetHitTime(const double t)                  { hit_time = t; }
   void          SetPosition(const G4ThreeVector & pos)      { position = pos; }
   void          SetTruth_Position(const G4ThreeVector & pos)      { truth_position = pos; } //*************************************
-  void          SetParticleName(const G4String p_name)      { ParticleName = p_name; }
-  void          SetParticleParent(const G4String p1_name)      { ParticleParent = p1_name; } //*******************************************************
-  void          SetProcessName(const G4String pr_name)      { ProcessName = pr_name; } //*******************************************************
+  void          SetParticleName(const G4String& p_name)     { ParticleName = p_name; }
+  void          SetParticleParent(const G4String& p1_name)     { ParticleParent = p1_name; } //*******************************************************
+  void          SetProcessName(const G4String& pr_name)     { ProcessName = pr_name; } //*******************************************************
+  void          SetWeight(const double w)                   { weight = w; }
 
 
-//void          SetProcessName(const G4String pr_name)      { ProcessName = pr_name; }
+//void          SetProcessName(const G4String& pr_name)     { ProcessName = pr_name; }
     
   G4double      GetKE()                const  { return K_E;}
   G4double      GetEdep()              const  { return eDep;}
@@ -61,15 +63,16 @@ public:
 
   G4double      GetNonIonisingEdep()   const  { return ni_eDep;}
   G4double      GetHitTime()           const  { return hit_time;}
+  G4double      GetWeight()            const  { return weight;}
   G4ThreeVector GetPosition()          const  { return position; }
   G4ThreeVector GetTruth_Position()          const  { return truth_position; } //***********************
   G4int         GetPixelNumber()       const  { return pixelNumber; }
   G4int         GetPlaneNumber()       const  { return planeNumber; }
   G4int         GetTrackNumber()       const  { return trackNumber; }
   G4bool	    GetIsPrimary()         const  { return isPrimary; }
-  G4String      GetParticleName()      const  { return ParticleName; }
+  const G4String& GetParticleName()    const  { return ParticleName; }
   G4String      GetParticleParent()      const  { return ParticleParent; } //*************************************************************************
-  G4String      GetProcessName()      const  { return ProcessName; } //*************************************************************************
+  const G4String& GetProcessName()     const  { return ProcessName; } //*************************************************************************
 
 //G4String      GetProcessName()       const  { return ProcessName; }
     
@@ -83,6 +86,7 @@ private:
 
   G4double      ni_eDep;
   G4double      hit_time;
+  G4double      weight;     // statistical weight of the track (importance biasing)
   G4ThreeVector position;
   G4ThreeVector truth_position; //******************************
   G4String      ParticleName;
@@ -98,17 +102,18 @@ typedef G4THitsCollection<SiHit_pix> SiHit_pixCollection;
 
 
 // -- new and delete overloaded operators:
-extern G4Allocator<SiHit_pix> SiHit_pixAllocator;
+extern G4ThreadLocal G4Allocator<SiHit_pix>* SiHit_pixAllocator;
 
 inline void* SiHit_pix::operator new(size_t)
 {
   void *aHit;
-  aHit = (void *) SiHit_pixAllocator.MallocSingle();
+  if ( !SiHit_pixAllocator ) {SiHit_pixAllocator = new G4Allocator<SiHit_pix>;}
+  aHit = (void *) SiHit_pixAllocator->MallocSingle();
   return aHit;
 }
 inline void SiHit_pix::operator delete(void *aHit)
 {
-  SiHit_pixAllocator.FreeSingle((SiHit_pix*) aHit);
+  SiHit_pixAllocator->FreeSingle((SiHit_pix*) aHit);
 }
 
 #endif
@@ -5,19 +5,22 @@
 #include "G4UserSteppingAction.hh"
 
 class G4VUserDetectorConstruction;
+class PhaseSpaceWriter;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 class SteppingAction : public G4UserSteppingAction
 {
   public:
-    SteppingAction(/*G4VUserDetectorConstruction* */);
+    SteppingAction(/*G4VUserDetectorConstruction* */ PhaseSpaceWriter* phsp = 0);
    ~SteppingAction(){};
 
-  //  void UserSteppingAction( const G4Step* );
+    // Records the particles entering the converter/sensor regions to the phase-space file
+    void UserSteppingAction( const G4Step* );
 	
 private:
     //G4VUserDetectorConstruction* myDetector;
+    PhaseSpaceWriter* phaseSpace;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -39,6 +39,10 @@ class T01TrackInformation : public G4VUserTrackInformation
   G4double              kineticEnergy; //***********************add this to define the k.E
 
    G4double              originalTime;
+  // origin vertex and initial kinetic energy of the track carrying this information,
+  // set once per track by TrackingAction::PreUserTrackingAction and read by the pixel SD
+   G4ThreeVector         vertexPosition;
+   G4double              vertexKineticEnergy;
   // G4String             Name;
 
 
@@ -50,20 +54,24 @@ class T01TrackInformation : public G4VUserTrackInformation
    inline G4double GetOriginalEnergy() const {return originalEnergy;}
    inline G4double GetOriginalTime() const {return originalTime;}
   inline G4double GetkineticEnergy() const {return kineticEnergy;} //**************************************
+   inline G4ThreeVector GetVertexPosition() const {return vertexPosition;}
+   inline G4double GetVertexKineticEnergy() const {return vertexKineticEnergy;}
+   inline void SetVertex(const G4ThreeVector& pos, const G4double ke) {vertexPosition = pos; vertexKineticEnergy = ke;}
 
   // inline G4String GetDynamicParticle() const {return DynamicParticle;}
 
 };
 
-extern G4Allocator<T01TrackInformation> aTrackInformationAllocator; 
+extern G4ThreadLocal G4Allocator<T01TrackInformation>* aTrackInformationAllocator; 
 
 inline void* T01TrackInformation::operator new(size_t)
 { void* aTrackInfo; 
-  aTrackInfo = (void*)aTrackInformationAllocator.MallocSingle(); 
+  if ( !aTrackInformationAllocator ) {aTrackInformationAllocator = new G4Allocator<T01TrackInformation>;}
+  aTrackInfo = (void*)aTrackInformationAllocator->MallocSingle(); 
   return aTrackInfo; 
 }
 
 inline void T01TrackInformation::operator delete(void *aTrackInfo) 
-{ aTrackInformationAllocator.FreeSingle((T01TrackInformation*)aTrackInfo);} 
+{ aTrackInformationAllocator->FreeSingle((T01TrackInformation*)aTrackInfo);} 
 
 #endif
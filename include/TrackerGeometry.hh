@@ -6,6 +6,7 @@
 #include <TVector3.h>
 #include <TLine.h>
 #include <TTree.h>
+#include <vector>
 
 class TrackerGeometry
 {
@@ -16,6 +17,9 @@ public:
   TrackerGeometry();
   TrackerGeometry(std::string input_macro_file);
   TrackerGeometry(TTree * t_geom);
+  // Default geometry with the strip sensor parameters of the running simulation (lengths in mm),
+  // used by the digitizer instead of re-reading tracker_geom.mac
+  TrackerGeometry(int n_strips, double pitch, double length, double det_thickness);
     
   // Destructor
   ~TrackerGeometry();
@@ -269,6 +273,56 @@ public:
     double get_stereo_u4_offset() const  { return stereo_u4_offset; }
     double get_stereo_v4_offset() const  { return stereo_v4_offset; }
     
+    /* Per-plane transform table, built by ComputeParameters()
+     *
+     * Planes are indexed 0..get_nb_of_planes()-1 in the order x1,u1,v1,x2,u2,v2,x3,u3,v3,x4,u4,v4
+     * (the plane numbers of the strip sensitive detectors). The plane index functions below
+     * give the same results as the corner/stereo getters combined with get_strip_origin() and
+     * world_2_det_transform(), without trigonometry or TVector3 temporaries per call.
+     * If the offsets are changed with the set_*_offset() functions, call ComputeParameters() again.
+     */
+    struct PlaneTransform
+    {
+        TVector3 origin;                // corner A of the det. (first strip)
+        TVector3 opp_origin;            // corner D of the det. (last strip)
+        double axis_x, axis_y;          // unit vector from A to D, the det. (strip number) axis
+        double stereo;                  // stereo angle, offset included
+        double sin_stereo, cos_stereo;
+        double pitch;
+        std::vector<double> strip_x;    // world x,y of the origin (bottom centre) of strip n at [n-1]
+        std::vector<double> strip_y;
+        std::vector<double> strip_pos;  // det. co-ordinate of the strip origins (mm along the axis)
+    };
+    
+    static int get_nb_of_planes()                           { return n_planes; }
+    // Moves the plane to the world centre (mm) and stereo angle (rad, offset included) it has in the
+    // simulation, corners and transform table included. ComputeParameters() goes back to the default placement
+    void set_plane_placement(int plane, const TVector3 & centre, double stereo_angle);
+    const PlaneTransform & get_plane(int plane) const       { return plane_transforms[plane]; }
+    
+    // Distance (mm) of the hit from corner A along the det. axis, as world_2_det_transform()
+    double world_2_det(int plane, double x, double y) const
+    {
+        const PlaneTransform & p = plane_transforms[plane];
+        return (x - p.origin.X())*p.axis_x + (y - p.origin.Y())*p.axis_y;
+    }
+    // Strip (1..strips) the hit is in, 0 if it is outside the det. (across or along the strips)
+    int get_strip_no(int plane, double x, double y) const
+    {
+        int strip_no;
+        get_strip_nos(plane, 1, &x, &y, &strip_no);
+        return strip_no;
+    }
+    // get_strip_no() for n_hits hits (x[i],y[i]) at once, result in strip_no[i]. The loop has no
+    // branches or calls so that the compiler can vectorise it
+    void get_strip_nos(int plane, int n_hits, const double * x, const double * y, int * strip_no) const;
+    // as get_strip_origin(corner A, strip_no, stereo angle) of the plane
+    TVector3 get_strip_origin(int plane, int strip_no) const
+    {
+        const PlaneTransform & p = plane_transforms[plane];
+        return TVector3( p.strip_x[strip_no-1], p.strip_y[strip_no-1], p.origin.Z() );
+    }
+    
     void ComputeParameters();
     void PrintGeometry();
     TVector3 get_strip_origin(TVector3 det_origin, int strip_no, double stereo_angle);
@@ -277,7 +331,9 @@ public:
     void draw_strip(TVector3 *x_low_b, TVector3 *x_mid_b, TVector3 *x_high_b, TVector3 *x_low_t, TVector3 *x_mid_t, TVector3 *x_high_t,
                     TVector3 strip_centre_origin, double stereo_angle);
     double world_2_det_transform(TVector3 det_origin, TVector3 det_opp_origin, TVector3 hit);
-    bool IsInsideStrip(TVector3 h, TVector3 origin, double stereo_angle);
+    bool IsInsideStrip(const TVector3 & h, const TVector3 & origin, double stereo_angle) const;
+    // as IsInsideStrip(h, get_strip_origin(plane, strip_no), stereo angle of the plane), with the cached sin/cos
+    bool IsInsideStrip(int plane, int strip_no, double x, double y) const;
     TVector3 get_average_strip_pos(TVector3 det_origin, std::vector<int> strips, double stereo_angle);
     TVector3 get_average_pos(TVector3 p1, TVector3 p2);
     TVector3 get_average_pos(std::vector<TVector3> points);
@@ -373,6 +429,12 @@ private:
     double stereo_x3_offset, stereo_u3_offset, stereo_v3_offset;
     double stereo_x4_offset, stereo_u4_offset, stereo_v4_offset;
     
+    // Fill plane_transforms from the corners and stereo angles, end of ComputeParameters()
+    void BuildPlaneTransforms();
+    void BuildPlaneTransform(int plane, const TVector3 & A, const TVector3 & D, double stereo);
+    static const int n_planes = 12;
+    PlaneTransform plane_transforms[n_planes];
+    
 };
 
 #endif
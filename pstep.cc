@@ -1,8 +1,18 @@
 
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#include "G4Threading.hh"
+#include "TROOT.h"
+#endif
 #include "G4RunManager.hh"
 #include "G4UImanager.hh"
 #include "QGSP_BIC_HP.hh"       
 #include "Shielding.hh" 
+#include "G4StepLimiterPhysics.hh"
+#include "G4GeometrySampler.hh"
+#include "G4ImportanceBiasing.hh"
+#include "G4ParallelWorldPhysics.hh"
+#include "G4GenericBiasingPhysics.hh"
 #include "G4Version.hh"
 
 #include "G4VisExecutive.hh"
@@ -17,14 +27,63 @@
 #include "PrimaryGeneratorAction.hh"
 #include "PhysicsList.hh"
 #include "QGSP_BERT.hh"
-#include "EventAction.hh"
-#include "RunAction.hh"
-
-#include "SteppingAction.hh"
+#include "ActionInitialization.hh"
+#include "ImportanceWorld.hh"
+#include "EventSeeder.hh"
+#include "PhysicsTableCache.hh"
 
 #include "TSystem.h"
 #include "TStopwatch.h"
 
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Looks for /vis/ commands in a batch macro and in the macros it runs with /control/execute,
+// /control/loop or /control/foreach, following /control/macroPath like G4UImanager does.
+// A macro that cannot be opened counts as using vis, so that a job is never broken by a
+// missing vis manager.
+static G4bool MacroUsesVis(const std::string& fileName, std::vector<std::string>& macroPath, G4int depth = 0)
+{
+  if ( depth > 20 ) {return false;}
+  std::ifstream macro(fileName.c_str());
+  for ( size_t i = 0 ; !macro.is_open() && i < macroPath.size() ; ++i )
+  {
+      macro.clear();
+      macro.open((macroPath[i] + "/" + fileName).c_str());
+  }
+  if ( !macro.is_open() ) {return true;}
+
+  std::string line;
+  while ( std::getline(macro, line) )
+  {
+      std::istringstream words(line);
+      std::string command, argument;
+      words >> command >> argument;
+      if ( command.empty() || command[0] == '#' ) {continue;}
+      if ( command.compare(0, 5, "/vis/") == 0 ) {return true;}
+      if ( command == "/control/macroPath" )
+      {
+          macroPath.clear();
+          std::istringstream dirs(argument);
+          std::string dir;
+          while ( std::getline(dirs, dir, ':') ) {if ( !dir.empty() ) macroPath.push_back(dir);}
+      }
+      else if ( ( command == "/control/execute" || command == "/control/loop" || command == "/control/foreach" )
+                && !argument.empty() )
+      {
+          // The macro is the first argument of all three. A name built from an alias
+          // ({...}) is only known at run time: assume vis
+          if ( argument.find('{') != std::string::npos ) {return true;}
+          if ( MacroUsesVis(argument, macroPath, depth+1) ) {return true;}
+      }
+  }
+  return false;
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 int main(int argc,char** argv)
@@ -34,58 +93,131 @@ int main(int argc,char** argv)
   timer.Start();
   Double_t rt = 0, /*r_et = 0,*/ cpt = 0/*, cp_et = 0*/;
     
-  //Comment out for non-random (deterministic) events
-  time_t systime = time(NULL);
+  // Command line: pstep [-t nThreads] [-s seed] [-b] [-f] [-c cacheDir] [macro]
+  // -t 0 uses all the cores of the machine, without -t the sequential run manager is used
+  // -s sets the run seed, every event is seeded from (seed, run ID, event ID), see EventSeeder
+  // -b switches on the neutron importance biasing through the shields (see /det/biasing/)
+  // -f forces the neutrons to interact in the converter film
+  // -c stores the physics tables in cacheDir and retrieves them in the next jobs with the same setup
+  // With -b or -f only the hit tallies weighted by weight_pix<N> are unbiased: event_weight,
+  // sum_event_weight, the signals and the skipEmptyEvents selection ignore the track weights
+  G4String macroFile = "";
+  G4int nThreads = -1;
+  G4long runSeed = -1;
+  G4bool importanceBiasing = false;
+  G4bool forceConverterCollision = false;
+  G4String physicsCacheDir = "";
+  for ( G4int i = 1 ; i < argc ; ++i )
+  {
+      G4String arg = argv[i];
+      if ( arg == "-t" && i+1 < argc ) {nThreads = atoi(argv[++i]);}
+      else if ( arg == "-s" && i+1 < argc ) {runSeed = atol(argv[++i]);}
+      else if ( arg == "-b" ) {importanceBiasing = true;}
+      else if ( arg == "-f" ) {forceConverterCollision = true;}
+      else if ( arg == "-c" && i+1 < argc ) {physicsCacheDir = argv[++i];}
+      else {macroFile = arg;}
+  }
+    
+  // Without -s the run seed comes from the clock, it is printed so that the run can be repeated
+  if ( runSeed < 0 ) {runSeed = time(NULL) % 900000000;}
   CLHEP::HepRandom::setTheEngine(new CLHEP::RanecuEngine);
-  CLHEP::HepRandom::setTheSeed(systime*G4UniformRand());
+  CLHEP::HepRandom::setTheSeed(runSeed);
+  EventSeeder* eventSeeder = new EventSeeder(runSeed);
     
   //Run manager
+#ifdef G4MULTITHREADED
+  G4RunManager * runManager = 0;
+  if ( nThreads >= 0 )
+  {
+      if ( nThreads == 0 ) {nThreads = G4Threading::G4GetNumberOfCores();}
+      // every worker thread owns its own TFile/TTree
+      ROOT::EnableThreadSafety();
+      G4MTRunManager * mtRunManager = new G4MTRunManager();
+      mtRunManager->SetNumberOfThreads(nThreads);
+      runManager = mtRunManager;
+      G4cout << "\nRunning with " << nThreads << " worker threads\n" << G4endl;
+  }
+  else {runManager = new G4RunManager();}
+#else
+  if ( nThreads >= 0 ) {G4cout << "\nGeant4 built without multithreading, -t option ignored\n" << G4endl;}
   G4RunManager * runManager = new G4RunManager();
+#endif
 
   //mandatory Initialization classes
   DetectorConstruction* detector = new DetectorConstruction();
+  // Ghost slabs carrying the neutron importances live in a parallel world
+  const G4String importanceWorldName = "ImportanceWorld";
+  ImportanceWorld* importanceWorld = 0;
+  if ( importanceBiasing )
+  {
+      importanceWorld = new ImportanceWorld(importanceWorldName, detector);
+      detector->RegisterParallelWorld(importanceWorld);
+  }
+  detector->Set_force_converter_collision(forceConverterCollision);
   runManager->SetUserInitialization(detector);
 
-  //G4VUserPhysicsList* physics = new PhysicsList();
-  G4VUserPhysicsList* physics = new QGSP_BIC_HP(); // This is the best physics list for Neutron simulations
-    //G4VUserPhysicsList* physics = new Shielding();
+  //G4VModularPhysicsList* physics = new PhysicsList();
+  G4VModularPhysicsList* physics = new QGSP_BIC_HP(); // This is the best physics list for Neutron simulations
+    //G4VModularPhysicsList* physics = new Shielding();
+  // Enforces the per-region max step set in DetectorConstruction (/det/step/...)
+  physics->RegisterPhysics(new G4StepLimiterPhysics());
+  // Splitting / Russian roulette of the neutrons at the importance slab boundaries,
+  // the world volume of the sampler is set when the processes are constructed
+  if ( importanceWorld )
+  {
+      G4GeometrySampler* sampler = new G4GeometrySampler(importanceWorld->GetWorldVolume(), "neutron");
+      sampler->SetParallel(true);
+      physics->RegisterPhysics(new G4ImportanceBiasing(sampler, importanceWorldName));
+      physics->RegisterPhysics(new G4ParallelWorldPhysics(importanceWorldName));
+      G4cout << "\nImportance biasing of the neutrons through the shields switched on\n" << G4endl;
+  }
+  // Physics and non-physics biasing of the neutrons, needed by the forced interaction
+  // operator attached to the converter film in DetectorConstruction::ConstructSDandField
+  if ( forceConverterCollision )
+  {
+      G4GenericBiasingPhysics* biasingPhysics = new G4GenericBiasingPhysics();
+      biasingPhysics->Bias("neutron");
+      physics->RegisterPhysics(biasingPhysics);
+      G4cout << "\nForced neutron interaction in the converter film switched on\n" << G4endl;
+  }
+  if ( importanceBiasing || forceConverterCollision )
+  {
+      G4cout << "Biased tracks: weight the hits with weight_pix<N>; event_weight, the signals and\n"
+             << "the skipEmptyEvents/eventChargeThreshold selection do not include the track weights\n" << G4endl;
+  }
 
   runManager->SetUserInitialization(physics);
    
-  //mandatory User Action classes
-  //G4VUserPrimaryGeneratorAction* gen_action = new PrimaryGeneratorAction();
-  PrimaryGeneratorAction* gen_action = new PrimaryGeneratorAction();
-  runManager->SetUserAction(gen_action);
-
-  //Optional User Action classes
-  //Event action (handles for beginning / end of event)
-  EventAction* event_action = new EventAction(detector);
-  //Run action (handles for beginning / end of event)
-  //This particular class needs a pointer to the event action
-  RunAction* run_action = new RunAction( gen_action, event_action, detector );
-    
-  SteppingAction* step_action = new SteppingAction(/*detector*/);
-  runManager->SetUserAction( step_action );
-  runManager->SetUserAction( event_action );
-  runManager->SetUserAction( run_action );
+  //User Action classes (built once per worker thread in MT mode)
+  runManager->SetUserInitialization(new ActionInitialization(detector));
 
   // Initialize G4 kernel
   runManager->Initialize();
+
+  // The tables are built (or retrieved) at the start of the first run
+  PhysicsTableCache* physicsTableCache = 0;
+  if ( physicsCacheDir != "" ) {physicsTableCache = new PhysicsTableCache(physicsCacheDir, physics);}
       
-  //Initilize the visualization manager
-  G4VisManager* visManager = new G4VisExecutive();
-  visManager->Initialize();
+  // The visualization manager loads every graphics driver, it is only built for
+  // interactive sessions and for batch macros that issue /vis/ commands
+  G4VisManager* visManager = 0;
+  std::vector<std::string> macroPath;
+  if ( macroFile == "" || MacroUsesVis(macroFile, macroPath) )
+  {
+      visManager = new G4VisExecutive();
+      visManager->Initialize();
+  }
+  else {G4cout << "\nNo /vis/ commands in " << macroFile << ", visualization manager not created\n" << G4endl;}
      
   // Get the pointer to the User Interface manager
   //
   G4UImanager * UImanager = G4UImanager::GetUIpointer();  
 
-  if (argc!=1)
+  if (macroFile != "")
   {  // batch mode
 	  //command line contains name of the macro to execute
       G4String command = "/control/execute ";
-      G4String fileName = argv[1];
-      UImanager->ApplyCommand(command+fileName);
+      UImanager->ApplyCommand(command+macroFile);
   }
   else  // interactive mode : define UI session
   {
@@ -103,6 +235,9 @@ int main(int argc,char** argv)
   //                 owned and deleted by the run manager, so they should not
   //                 be deleted in the main() program !
 
+  delete visManager;
+  delete physicsTableCache;
+  delete eventSeeder;
   delete runManager;
     
     timer.Stop();
@@ -0,0 +1,40 @@
+
+#include "ActionInitialization.hh"
+#include "DetectorConstruction.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "EventAction.hh"
+#include "RunAction.hh"
+#include "SteppingAction.hh"
+#include "TrackingAction.hh"
+
+ActionInitialization::ActionInitialization( DetectorConstruction* myDC ) :
+	G4VUserActionInitialization(), myDetector(myDC)
+{}
+
+void ActionInitialization::BuildForMaster() const
+{
+	// The master does not process events, its run action
+	// has no EventAction nor PrimaryGeneratorAction attached
+	SetUserAction( new RunAction( 0, 0, myDetector ) );
+}
+
+void ActionInitialization::Build() const
+{
+	//mandatory User Action classes
+	PrimaryGeneratorAction* gen_action = new PrimaryGeneratorAction();
+	SetUserAction( gen_action );
+
+	//Optional User Action classes
+	//Event action (handles for beginning / end of event)
+	EventAction* event_action = new EventAction( myDetector );
+	//Run action (handles for beginning / end of event)
+	//This particular class needs a pointer to the event action
+	RunAction* run_action = new RunAction( gen_action, event_action, myDetector );
+
+	SteppingAction* step_action = new SteppingAction(/*detector*/ run_action->GetPhaseSpaceWriter());
+	SetUserAction( step_action );
+	//Tracking action attaches the T01TrackInformation read by the pixel SD
+	SetUserAction( new TrackingAction() );
+	SetUserAction( event_action );
+	SetUserAction( run_action );
+}
@@ -21,13 +21,22 @@
 #include "SensitiveDetector.hh"
 #include "SensitiveDetector_pix.hh"
 #include "G4SDManager.hh"
+#include "DetectorPlanes.hh"
+#include "G4BOptrForceCollision.hh"
 
 #include "G4UserLimits.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4ProductionCutsTable.hh"
 #include "G4PhysicalConstants.hh"
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
 
-DetectorConstruction::DetectorConstruction()
+DetectorConstruction::DetectorConstruction() :
+    sensorRegion(0),
+    converterRegion(0),
+    force_converter_collision(false)
 {
 	//Create a messanger (defines custom UI commands)
 	messenger = new DetectorMessenger(this);
@@ -367,6 +376,23 @@ contact2Theta = 0.*deg;
     // Build/readout strips or pixels or both
     build_strip_detectors = false;
     build_pixel_detectors = true;
+    
+    // Digitize only the channels with charge, noise hits above threshold (in e-) are drawn statistically
+    sparse_digitization = true;
+    digi_noise_threshold = 0.0;
+    
+    // Step limits and production cuts of the sensor/converter/world regions: physics-driven steps
+    // and the physics list cuts everywhere unless set by macro (/det/step/...). A fixed max step
+    // in the sensors costs (thickness/step) steps per charged track, e.g. 750 for 0.2um in 150um Si
+    sensor_max_step = 0.0;
+    converter_max_step = 0.0;
+    other_max_step = 0.0;
+    sensor_prod_cut = 0.0;
+    converter_prod_cut = 0.0;
+    
+    // Importance biasing (only with pstep -b): 1 cm slabs, importance doubled in each slab
+    importance_slabs = 5;
+    importance_ratio = 2.0;
     // **************************** THESE PARAMETER YOU NEED TO FOCUS ON IT (PIX1, PIX2, PIX3 AND PIX4), For LYSO modelling only consider Pixel 1
     // Pixel properties
     
@@ -1217,84 +1243,211 @@ G4Box * solidShield = new G4Box("shield",halfShieldSizeXY,halfShieldSizeXY,halfS
     
     //***********************************************************************************//
 
-	// ----------------------------------------------------------
-	// -- Binding SensitiveDetector code to sensor strip volume:
-	// -- Note that it is possible to set the sensitive detector
-	// -- at construction of the G4LogicalVolume (fith argument
-	// -- is a G4VSensitiveDetector*).
-	// ----------------------------------------------------------
-	// Every time the /det/update command is executed this
-	// method is called since geometry is recomputed.
-	// However we do not need to create a new SD, but reuse the
-	// already existing one
-    
-    static SensitiveDetector_pix * sensitive_det_pix1 = 0;
-    static SensitiveDetector_pix * sensitive_det_pix2 = 0;
-    static SensitiveDetector_pix * sensitive_det_pix3 = 0;
-    static SensitiveDetector_pix * sensitive_det_pix4 = 0;
+    //--------- Visualization attributes -------------------------------
     
-	static SensitiveDetector* sensitive_det_x1 = 0;
-	static SensitiveDetector* sensitive_det_u1 = 0;
-	static SensitiveDetector* sensitive_det_v1 = 0;
+	logicWorld->SetVisAttributes(new G4VisAttributes(white));
+	//logicWorld->SetVisAttributes(G4VisAttributes::Invisible);
+    G4VisAttributes * PhantomVisAtt = new G4VisAttributes(white);
+    PhantomVisAtt->SetForceWireframe(true); // Set the forced wireframe style
+    logicPhantom->SetVisAttributes(PhantomVisAtt);
+
+    //******************Shielding changes****************
+    G4VisAttributes * ShieldVisAtt = new G4VisAttributes(blue);
+    ShieldVisAtt->SetForceWireframe(true); // Set the forced wireframe style
+    logicShield->SetVisAttributes(ShieldVisAtt);
     
-    G4SDManager* SDman = G4SDManager::GetSDMpointer();
+    //****************************End*******************
+    //******************************************************************************************************************************************
+   G4VisAttributes * FilmVisAtt = new G4VisAttributes(white);
+    FilmVisAtt->SetForceSolid(true); // Set the forced wireframe style
+    logicFilm->SetVisAttributes(FilmVisAtt);
 
-    //if( build_pixel_detectors)
-    //{
-        if ( !sensitive_det_pix1 )
-        {
-            sensitive_det_pix1 = new SensitiveDetector_pix("SiPixel_pix1");
-            //We register now the SD with the manager
-            SDman->AddNewDetector(sensitive_det_pix1);
-        }
-        
-        if ( !sensitive_det_pix2 )
-        {
-            sensitive_det_pix2 = new SensitiveDetector_pix("SiPixel_pix2");
-            //We register now the SD with the manager
-            SDman->AddNewDetector(sensitive_det_pix2);
-        }
+  G4VisAttributes * Contact1VisAtt = new G4VisAttributes(red);
+    Contact1VisAtt->SetForceSolid(true); // Set the forced wireframe style
+    logicContact1->SetVisAttributes(Contact1VisAtt);
+
+  G4VisAttributes * Contact2VisAtt = new G4VisAttributes(red);
+    Contact2VisAtt->SetForceSolid(true); // Set the forced wireframe style
+    logicContact2->SetVisAttributes(Contact2VisAtt);
+    //*****************************************************************************************************************************************
+    
+    // Step limits and production cuts are set per region rather than per volume: a G4UserLimits
+    // on the world forced neutrons into thousands of 200um steps through air and the shields.
+    // Regions survive a geometry rebuild (the old volumes de-register themselves), so they are
+    // only created once and the new volumes are added to them.
+    G4RegionStore* regionStore = G4RegionStore::GetInstance();
+    
+    sensorRegion = regionStore->GetRegion("SensorRegion",false);
+    if ( !sensorRegion ) {sensorRegion = new G4Region("SensorRegion");}
+    sensorRegion->AddRootLogicalVolume(logic_pix1_SensorPlane);
+    sensorRegion->AddRootLogicalVolume(logic_pix2_SensorPlane);
+    sensorRegion->AddRootLogicalVolume(logic_pix3_SensorPlane);
+    sensorRegion->AddRootLogicalVolume(logic_pix4_SensorPlane);
+    
+    sensorRegion->AddRootLogicalVolume(logic_x1_SensorPlane);
+    sensorRegion->AddRootLogicalVolume(logic_u1_SensorPlane);
+    sensorRegion->AddRootLogicalVolume(logic_v1_SensorPlane);
+    
+    converterRegion = regionStore->GetRegion("ConverterRegion",false);
+    if ( !converterRegion ) {converterRegion = new G4Region("ConverterRegion");}
+    converterRegion->AddRootLogicalVolume(logicFilm);
+    
+    ApplyRegionSettings();
     
-    if ( !sensitive_det_pix3 )
+	//always return the physical World
+	return physiWorld;
+}
+
+G4bool DetectorConstruction::Get_strip_plane_placement( const G4int plane, G4ThreeVector& pos, G4double& angle ) const
+{
+    // Only the first module (x1,u1,v1) is built
+    switch ( plane )
     {
-        sensitive_det_pix3 = new SensitiveDetector_pix("SiPixel_pix3");
-        //We register now the SD with the manager
-        SDman->AddNewDetector(sensitive_det_pix3);
+        case 0: pos = pos_x1_Sensor; angle = x1_SensorTheta; break;
+        case 1: pos = pos_u1_Sensor; angle = u1_SensorTheta; break;
+        case 2: pos = pos_v1_Sensor; angle = v1_SensorTheta; break;
+        default: return false;
     }
+    // The planes are placed inside the phantom, which is rotated around z and then translated
+    pos.rotateZ(-phantomTheta);
+    pos += pos_phantom;
+    angle += phantomTheta;
+    return true;
+}
+
+void DetectorConstruction::ApplyRegionSettings()
+{
+    // Regions are created by Construct(), until then the values are only stored
+    if ( !sensorRegion || !converterRegion ) return;
+    
+    //Available arguements for G4UserLimits()
+    /*G4UserLimits(G4double uStepMax = DBL_MAX, G4double uTrakMax = DBL_MAX, G4double uTimeMax = DBL_MAX, G4double uEkinMin = 0.,G4double uRangMin = 0. );*/
+    // Only the max step is used, it is enforced by G4StepLimiterPhysics (registered in pstep.cc)
+    if ( !sensorRegion->GetUserLimits() ) {sensorRegion->SetUserLimits(new G4UserLimits());}
+    sensorRegion->GetUserLimits()->SetMaxAllowedStep( sensor_max_step > 0. ? sensor_max_step : DBL_MAX );
+    
+    if ( !converterRegion->GetUserLimits() ) {converterRegion->SetUserLimits(new G4UserLimits());}
+    converterRegion->GetUserLimits()->SetMaxAllowedStep( converter_max_step > 0. ? converter_max_step : DBL_MAX );
     
-    if ( !sensitive_det_pix4 )
+    // Everything else (world, phantom, shields, contacts) is in the default world region
+    G4Region* worldRegion = G4RegionStore::GetInstance()->GetRegion("DefaultRegionForTheWorld",false);
+    if ( worldRegion )
     {
-        sensitive_det_pix4 = new SensitiveDetector_pix("SiPixel_pix4");
-        //We register now the SD with the manager
-        SDman->AddNewDetector(sensitive_det_pix4);
+        if ( !worldRegion->GetUserLimits() ) {worldRegion->SetUserLimits(new G4UserLimits());}
+        worldRegion->GetUserLimits()->SetMaxAllowedStep( other_max_step > 0. ? other_max_step : DBL_MAX );
     }
-    //}
     
-    //if( build_strip_detectors)
-    //{
-        if ( !sensitive_det_x1 )
-        {
-            sensitive_det_x1 = new SensitiveDetector("SiStrip_x1");
-            //We register now the SD with the manager
-            SDman->AddNewDetector(sensitive_det_x1);
-        }
-        
-       
-        if ( !sensitive_det_u1 )
-        {
-            sensitive_det_u1 = new SensitiveDetector("SiStrip_u1");
-            //We register now the SD with the manager
-            SDman->AddNewDetector(sensitive_det_u1);
-        }
-        
-        
-        if ( !sensitive_det_v1 )
-        {
-            sensitive_det_v1 = new SensitiveDetector("SiStrip_v1");
-            //We register now the SD with the manager
-            SDman->AddNewDetector(sensitive_det_v1);
-        }
-    //}
+    // Production cuts, the world keeps the physics list default
+    SetRegionProductionCut( sensorRegion, sensor_prod_cut );
+    SetRegionProductionCut( converterRegion, converter_prod_cut );
+}
+
+void DetectorConstruction::SetRegionProductionCut( G4Region* region, G4double cut )
+{
+    // <= 0: the region shares the default cuts of the physics list. Own cuts are only
+    // created for a set value, never written into the shared default object
+    G4ProductionCuts* defaultCuts = G4ProductionCutsTable::GetProductionCutsTable()->GetDefaultProductionCuts();
+    if ( cut <= 0. )
+    {
+        region->SetProductionCuts(defaultCuts);
+        return;
+    }
+    G4ProductionCuts* cuts = region->GetProductionCuts();
+    if ( !cuts || cuts == defaultCuts )
+    {
+        cuts = new G4ProductionCuts();
+        region->SetProductionCuts(cuts);
+    }
+    cuts->SetProductionCut(cut);
+}
+
+void DetectorConstruction::Set_sensor_max_step( const G4double& step )
+{
+    sensor_max_step = step;
+    ApplyRegionSettings();
+}
+
+void DetectorConstruction::Set_converter_max_step( const G4double& step )
+{
+    converter_max_step = step;
+    ApplyRegionSettings();
+}
+
+void DetectorConstruction::Set_other_max_step( const G4double& step )
+{
+    other_max_step = step;
+    ApplyRegionSettings();
+}
+
+void DetectorConstruction::Set_sensor_prod_cut( const G4double& cut )
+{
+    sensor_prod_cut = cut;
+    ApplyRegionSettings();
+}
+
+void DetectorConstruction::Set_converter_prod_cut( const G4double& cut )
+{
+    converter_prod_cut = cut;
+    ApplyRegionSettings();
+}
+
+G4VPhysicalVolume* DetectorConstruction::Get_strip_plane_volume( const G4int plane, G4bool& isDUT ) const
+{
+    // Only the first module (x1,u1,v1) is built
+    switch ( plane )
+    {
+        case 0: isDUT = is_x1_PlaneDUT; return physi_x1_Sensor;
+        case 1: isDUT = is_u1_PlaneDUT; return physi_u1_Sensor;
+        case 2: isDUT = is_v1_PlaneDUT; return physi_v1_Sensor;
+        default: isDUT = false; return 0;
+    }
+}
+
+G4VPhysicalVolume* DetectorConstruction::Get_pixel_plane_volume( const G4int plane, G4bool& isDUT ) const
+{
+    switch ( plane )
+    {
+        case 0: isDUT = is_pix1_PlaneDUT; return physi_pix1_Sensor;
+        case 1: isDUT = is_pix2_PlaneDUT; return physi_pix2_Sensor;
+        case 2: isDUT = is_pix3_PlaneDUT; return physi_pix3_Sensor;
+        case 3: isDUT = is_pix4_PlaneDUT; return physi_pix4_Sensor;
+        default: isDUT = false; return 0;
+    }
+}
+
+void DetectorConstruction::AttachSensitiveDetector( G4VPhysicalVolume* plane, const G4bool isDUT, G4VSensitiveDetector* sensitive_det )
+{
+    if ( !plane )
+    {
+        G4cout << "WARNING: no volume for " << sensitive_det->GetName()
+               << " in this geometry, the plane will have no hits" << G4endl;
+        return;
+    }
+    G4LogicalVolume* log = plane->GetLogicalVolume();
+    // DUT: the strips/rows are the first (replicated) daughter of the plane
+    if ( isDUT ) {log = log->GetDaughter(0)->GetLogicalVolume();}
+    log->SetSensitiveDetector(sensitive_det);
+}
+
+// Sensitive detectors are created here rather than in Construct() so that,
+// in a multithreaded run, every worker thread builds and owns its own instances
+// (the geometry itself is shared and only built by the master).
+void DetectorConstruction::ConstructSDandField()
+{
+	// ----------------------------------------------------------
+	// -- Binding SensitiveDetector code to sensor strip volume:
+	// -- Note that it is possible to set the sensitive detector
+	// -- at construction of the G4LogicalVolume (fith argument
+	// -- is a G4VSensitiveDetector*).
+	// ----------------------------------------------------------
+	// Every time the /det/update command is executed this
+	// method is called (on each thread) since geometry is recomputed.
+	// However we do not need to create a new SD, but reuse the
+	// already existing one of this thread: the SD manager is per
+	// thread, so the SDs are looked up there by name.
+	
+	// One SD per plane, Get_nb_of_planes() strip planes and Get_nb_of_pix_planes()
+	// pixel planes, named after the plane (see DetectorPlanes)
     
 	// This part here is used to associated the sensitive detector to the
 	// logical volume of a plane in case it is a DUT.
@@ -1316,192 +1469,74 @@ G4Box * solidShield = new G4Box("shield",halfShieldSizeXY,halfShieldSizeXY,halfS
     // just defined as a plane with no strips (see else statement) position
     // and energy of events is still read out but stip variables will be empty or 0.
     
+    G4SDManager* SDman = G4SDManager::GetSDMpointer();
+    
     G4cout << "\nAttempting to find sensitive detectors for pixels...\n" << G4endl;
     
-    if( build_pixel_detectors )
+    for ( G4int plane = 0 ; plane < Get_nb_of_pix_planes() ; ++plane )
     {
-        if ( is_pix1_PlaneDUT )
-        {
-            const G4LogicalVolume* log = physi_pix1_Sensor->GetLogicalVolume();
-            log->GetDaughter(0)->GetLogicalVolume()->SetSensitiveDetector(sensitive_det_pix1);
-        }
-        else
-        {
-            G4LogicalVolume* log = physi_pix1_Sensor->GetLogicalVolume();
-            log->SetSensitiveDetector(sensitive_det_pix1);
-        }
-        
-        if ( is_pix2_PlaneDUT )
-        {
-            const G4LogicalVolume* log = physi_pix2_Sensor->GetLogicalVolume();
-            log->GetDaughter(0)->GetLogicalVolume()->SetSensitiveDetector(sensitive_det_pix2);
-        }
-        else
+        const G4String name = DetectorPlanes::PixelHitsCollectionName(plane);
+        G4VSensitiveDetector* sensitive_det = SDman->FindSensitiveDetector(name, false);
+        if ( !sensitive_det )
         {
-            G4LogicalVolume* log = physi_pix2_Sensor->GetLogicalVolume();
-            log->SetSensitiveDetector(sensitive_det_pix2);
-        }
-        
-        if ( is_pix3_PlaneDUT )
-        {
-            const G4LogicalVolume* log = physi_pix3_Sensor->GetLogicalVolume();
-            log->GetDaughter(0)->GetLogicalVolume()->SetSensitiveDetector(sensitive_det_pix3);
-        }
-        else
-        {
-            G4LogicalVolume* log = physi_pix3_Sensor->GetLogicalVolume();
-            log->SetSensitiveDetector(sensitive_det_pix3);
-        }
-        
-        if ( is_pix4_PlaneDUT )
-        {
-            const G4LogicalVolume* log = physi_pix4_Sensor->GetLogicalVolume();
-            log->GetDaughter(0)->GetLogicalVolume()->SetSensitiveDetector(sensitive_det_pix4);
+            sensitive_det = new SensitiveDetector_pix(name);
+            //We register now the SD with the manager
+            SDman->AddNewDetector(sensitive_det);
         }
-        else
+        if ( build_pixel_detectors )
         {
-            G4LogicalVolume* log = physi_pix4_Sensor->GetLogicalVolume();
-            log->SetSensitiveDetector(sensitive_det_pix4);
+            G4bool isDUT = false;
+            AttachSensitiveDetector( Get_pixel_plane_volume(plane, isDUT), isDUT, sensitive_det );
         }
     }
     
     G4cout << "\nFinished Attempting to find sensitive detectors for pixels...\n" << G4endl;
     
     G4cout << "\nAttempting to find sensitive detectors for strips...\n" << G4endl;
-    if( build_strip_detectors )
+    
+    for ( G4int plane = 0 ; plane < Get_nb_of_planes() ; ++plane )
     {
-        if ( is_x1_PlaneDUT )
-        {
-            const G4LogicalVolume* log = physi_x1_Sensor->GetLogicalVolume();
-            log->GetDaughter(0)->GetLogicalVolume()->SetSensitiveDetector(sensitive_det_x1);
-        }
-        else
-        {
-            G4LogicalVolume* log = physi_x1_Sensor->GetLogicalVolume();
-            log->SetSensitiveDetector(sensitive_det_x1);
-        }
-        
-        if ( is_u1_PlaneDUT )
-        {
-            const G4LogicalVolume* log = physi_u1_Sensor->GetLogicalVolume();
-            log->GetDaughter(0)->GetLogicalVolume()->SetSensitiveDetector(sensitive_det_u1);
-        }
-        else
-        {
-            G4LogicalVolume* log = physi_u1_Sensor->GetLogicalVolume();
-            log->SetSensitiveDetector(sensitive_det_u1);
-        }
-        
-        if ( is_v1_PlaneDUT )
+        const G4String name = DetectorPlanes::StripHitsCollectionName(plane);
+        G4VSensitiveDetector* sensitive_det = SDman->FindSensitiveDetector(name, false);
+        if ( !sensitive_det )
         {
-            const G4LogicalVolume* log = physi_v1_Sensor->GetLogicalVolume();
-            log->GetDaughter(0)->GetLogicalVolume()->SetSensitiveDetector(sensitive_det_v1);
+            sensitive_det = new SensitiveDetector(name);
+            //We register now the SD with the manager
+            SDman->AddNewDetector(sensitive_det);
         }
-        else
+        if ( build_strip_detectors )
         {
-            G4LogicalVolume* log = physi_v1_Sensor->GetLogicalVolume();
-            log->SetSensitiveDetector(sensitive_det_v1);
+            G4bool isDUT = false;
+            AttachSensitiveDetector( Get_strip_plane_volume(plane, isDUT), isDUT, sensitive_det );
         }
     }
     
     G4cout << "\nFinished Attempting to find sensitive detectors for strips...\n" << G4endl;
     
-    //--------- Visualization attributes -------------------------------
-    
-	logicWorld->SetVisAttributes(new G4VisAttributes(white));
-	//logicWorld->SetVisAttributes(G4VisAttributes::Invisible);
-    G4VisAttributes * PhantomVisAtt = new G4VisAttributes(white);
-    PhantomVisAtt->SetForceWireframe(true); // Set the forced wireframe style
-    logicPhantom->SetVisAttributes(PhantomVisAtt);
-
-    //******************Shielding changes****************
-    G4VisAttributes * ShieldVisAtt = new G4VisAttributes(blue);
-    ShieldVisAtt->SetForceWireframe(true); // Set the forced wireframe style
-    logicShield->SetVisAttributes(ShieldVisAtt);
-    
-    //****************************End*******************
-    //******************************************************************************************************************************************
-   G4VisAttributes * FilmVisAtt = new G4VisAttributes(white);
-    FilmVisAtt->SetForceSolid(true); // Set the forced wireframe style
-    logicFilm->SetVisAttributes(FilmVisAtt);
-
-  G4VisAttributes * Contact1VisAtt = new G4VisAttributes(red);
-    Contact1VisAtt->SetForceSolid(true); // Set the forced wireframe style
-    logicContact1->SetVisAttributes(Contact1VisAtt);
-
-  G4VisAttributes * Contact2VisAtt = new G4VisAttributes(red);
-    Contact2VisAtt->SetForceSolid(true); // Set the forced wireframe style
-    logicContact2->SetVisAttributes(Contact2VisAtt);
-    //*****************************************************************************************************************************************
-    
-    //G4double minStep = 0.2*um; //Smaller steps results in better energy loss values (lower fluctuation)
-    //G4double minTrack = 0.2*um;
-    //G4UserLimits* stepLimitMin = new G4UserLimits(minStep);
-    
-    //Available arguements for G4UserLimits()
-    /*G4UserLimits(G4double uStepMax = DBL_MAX, G4double uTrakMax = DBL_MAX, G4double uTimeMax = DBL_MAX, G4double uEkinMin = 0.,G4double uRangMin = 0. );*/
-    
-    
-    //Doesn't seem to work at the moment, same cut value of 10um everywhere which is set in PhysicsList.cc
-    //need to alter physics list and put into messenger, although assigning specific range cuts to a region
-    //is not recommended unless geometry is complex see here:
-    //http://geant4.cern.ch/G4UsersDocuments/UsersGuides/ForApplicationDeveloper/html/TrackingAndPhysics/cutsPerRegion.html
-    
-    G4double uStepMin = 0.2*um;
-    G4double uTrakMin = 0.2*um;
-    G4UserLimits* stepLimitMin = new G4UserLimits(uStepMin,uTrakMin);
-    
-    logic_pix1_SensorPlane->SetUserLimits(stepLimitMin);
-    logic_pix2_SensorPlane->SetUserLimits(stepLimitMin);
-    logic_pix3_SensorPlane->SetUserLimits(stepLimitMin);
-    logic_pix4_SensorPlane->SetUserLimits(stepLimitMin);
-    
-    logic_x1_SensorPlane->SetUserLimits(stepLimitMin);
-    logic_u1_SensorPlane->SetUserLimits(stepLimitMin);
-    logic_v1_SensorPlane->SetUserLimits(stepLimitMin);
-    
-    //G4double maxStep = 200*um; //Smaller steps results in better energy loss values (lower fluctuation)
-    //G4UserLimits* stepLimitMax = new G4UserLimits(maxStep);
-
-    G4double uStepMax = 200*um;
-    G4double uTrakMax = 200*um;
-    G4UserLimits* stepLimitMax = new G4UserLimits(uStepMax,uTrakMax);
-    
-    logicWorld->SetUserLimits(stepLimitMax);
-    logicPhantom->SetUserLimits(stepLimitMax);
-    logicShield->SetUserLimits(stepLimitMax);//********************
-    //**********************************************************************
-    logicFilm->SetUserLimits(stepLimitMax);
-
-    logicContact1->SetUserLimits(stepLimitMax);
-
-    logicContact2->SetUserLimits(stepLimitMax);
-
-
-
-    //**********************************************************************
+    // Forced interaction of the neutrons in the converter film: almost all thermal neutrons
+    // cross the 1 um film without interacting, the operator forces one interaction
+    // (chosen according to the cross sections, mostly 6Li(n,t)alpha) and corrects the
+    // weight of the neutron and of its secondaries. Biasing operators are thread local
+    // like the SDs, the neutron must be biased with G4GenericBiasingPhysics (pstep -f).
+    if ( force_converter_collision )
+    {
+        static G4ThreadLocal G4BOptrForceCollision* force_collision_film = 0;
+        if ( !force_collision_film ) {force_collision_film = new G4BOptrForceCollision("neutron","forceCollisionFilm");}
+        force_collision_film->AttachTo( physi_film->GetLogicalVolume() );
+        G4cout << "\nForced neutron interaction attached to " << physi_film->GetLogicalVolume()->GetName() << "\n" << G4endl;
+    }
     
-	//always return the physical World
-	return physiWorld;
 }
 
 
-#include "G4RunManager.hh"
-#include "G4PhysicalVolumeStore.hh"
-#include "G4LogicalVolumeStore.hh"
-#include "G4SolidStore.hh"
-
 // This function is called from the messenger to compute
 // and build all geometry changes
 void DetectorConstruction::UpdateGeometry()
 {
     //G4cout << "\nAbout to rebuild geometry\n" << G4endl;
     
-  // Cleanup old geometry
-  G4GeometryManager::GetInstance()->OpenGeometry();
-  G4PhysicalVolumeStore::GetInstance()->Clean();
-  G4LogicalVolumeStore::GetInstance()->Clean();
-  G4SolidStore::GetInstance()->Clean();
-
-  G4RunManager::GetRunManager()->DefineWorldVolume(Construct());
+  // Cleanup old geometry and flag it for rebuilding. The run manager calls
+  // Construct() and ConstructSDandField() again (on the master and on every
+  // worker thread in MT mode) at the next /run/beamOn
+  G4RunManager::GetRunManager()->ReinitializeGeometry(true);
 }
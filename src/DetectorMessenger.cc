@@ -5,6 +5,7 @@
 #include "G4UIdirectory.hh"
 #include "G4UIcmdWithAString.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithADouble.hh"
 #include "G4UIcmdWithAnInteger.hh"
 #include "G4UIcmdWithoutParameter.hh"
 #include "G4UIcmdWithABool.hh"
@@ -29,6 +30,81 @@ DetectorMessenger::DetectorMessenger(DetectorConstruction * det):detector(det)
   build_pixel_detCmd->SetGuidance("Select setup true to have pixel detectors built");
   build_pixel_detCmd->AvailableForStates(G4State_Idle);
   
+  // Sparse digitization: digits only for channels with charge
+  sparse_digiCmd = new G4UIcmdWithABool("/det/sparse_digi",this);
+  sparse_digiCmd->SetGuidance("Select true to create digits only for strips/pixels with charge,");
+  sparse_digiCmd->SetGuidance("noise-only channels above /det/digi_noise_threshold are drawn statistically");
+  sparse_digiCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  
+  digi_noise_thresholdCmd = new G4UIcmdWithADouble("/det/digi_noise_threshold",this);
+  digi_noise_thresholdCmd->SetGuidance("Level (in elementary charge units, pedestal included) a noise-only channel");
+  digi_noise_thresholdCmd->SetGuidance("must exceed to be digitized in sparse mode");
+  digi_noise_thresholdCmd->SetParameterName("digi_noise_threshold",true);
+  digi_noise_thresholdCmd->SetDefaultValue(0.);
+  digi_noise_thresholdCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  
+  //**************** STEP LIMITS AND PRODUCTION CUTS PER REGION **********************************//
+  
+  stepDir = new G4UIdirectory("/det/step/");
+  stepDir->SetGuidance("step limits and production cuts of the sensor, converter and world regions");
+  
+  sensor_max_stepCmd = new G4UIcmdWithADoubleAndUnit("/det/step/sensor_max_step",this);
+  sensor_max_stepCmd->SetGuidance("Max. step in the sensor planes (pixel and strip), 0 for no limit (default)");
+  sensor_max_stepCmd->SetParameterName("sensor_max_step",true);
+  sensor_max_stepCmd->SetDefaultValue(0.0);
+  sensor_max_stepCmd->SetUnitCategory("Length");
+  sensor_max_stepCmd->SetDefaultUnit("um");
+  sensor_max_stepCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  
+  converter_max_stepCmd = new G4UIcmdWithADoubleAndUnit("/det/step/converter_max_step",this);
+  converter_max_stepCmd->SetGuidance("Max. step in the neutron converter film, 0 for no limit (default)");
+  converter_max_stepCmd->SetParameterName("converter_max_step",true);
+  converter_max_stepCmd->SetDefaultValue(0.0);
+  converter_max_stepCmd->SetUnitCategory("Length");
+  converter_max_stepCmd->SetDefaultUnit("um");
+  converter_max_stepCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  
+  other_max_stepCmd = new G4UIcmdWithADoubleAndUnit("/det/step/other_max_step",this);
+  other_max_stepCmd->SetGuidance("Max. step in the rest of the world (air, phantom, shields, contacts), 0 for no limit (default)");
+  other_max_stepCmd->SetParameterName("other_max_step",true);
+  other_max_stepCmd->SetDefaultValue(0.0);
+  other_max_stepCmd->SetUnitCategory("Length");
+  other_max_stepCmd->SetDefaultUnit("um");
+  other_max_stepCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  
+  sensor_prod_cutCmd = new G4UIcmdWithADoubleAndUnit("/det/step/sensor_prod_cut",this);
+  sensor_prod_cutCmd->SetGuidance("Production cut (range) for e-, e+ and gamma in the sensor planes, 0 for the physics list default (default)");
+  sensor_prod_cutCmd->SetParameterName("sensor_prod_cut",true);
+  sensor_prod_cutCmd->SetDefaultValue(0.0);
+  sensor_prod_cutCmd->SetUnitCategory("Length");
+  sensor_prod_cutCmd->SetDefaultUnit("um");
+  sensor_prod_cutCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  
+  converter_prod_cutCmd = new G4UIcmdWithADoubleAndUnit("/det/step/converter_prod_cut",this);
+  converter_prod_cutCmd->SetGuidance("Production cut (range) for e-, e+ and gamma in the neutron converter film, 0 for the physics list default (default)");
+  converter_prod_cutCmd->SetParameterName("converter_prod_cut",true);
+  converter_prod_cutCmd->SetDefaultValue(0.0);
+  converter_prod_cutCmd->SetUnitCategory("Length");
+  converter_prod_cutCmd->SetDefaultUnit("um");
+  converter_prod_cutCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  
+  biasingDir = new G4UIdirectory("/det/biasing/");
+  biasingDir->SetGuidance("importance biasing of the neutrons through the shields (run pstep with -b), applied by /det/update");
+  
+  importance_slabsCmd = new G4UIcmdWithAnInteger("/det/biasing/slabs",this);
+  importance_slabsCmd->SetGuidance("Number of importance slabs each shield (PE and Pb) is divided into along z");
+  importance_slabsCmd->SetParameterName("slabs",true);
+  importance_slabsCmd->SetDefaultValue(5);
+  importance_slabsCmd->SetRange("slabs>=1");
+  importance_slabsCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  
+  importance_ratioCmd = new G4UIcmdWithADouble("/det/biasing/importanceRatio",this);
+  importance_ratioCmd->SetGuidance("Importance ratio between consecutive slabs (splitting factor going downstream)");
+  importance_ratioCmd->SetParameterName("importanceRatio",true);
+  importance_ratioCmd->SetDefaultValue(2.0);
+  importance_ratioCmd->SetRange("importanceRatio>=1");
+  importance_ratioCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+  
   set_nb_of_stripsCmd = new G4UIcmdWithAnInteger("/det/n_strips",this);
   set_nb_of_stripsCmd->SetGuidance("Select no. of strips in each detector plane");
   set_nb_of_stripsCmd->SetParameterName("n_strips",true);
@@ -532,6 +608,18 @@ DetectorMessenger::~DetectorMessenger()
 {
   delete build_strip_detCmd;
   delete build_pixel_detCmd;
+  delete sparse_digiCmd;
+  delete digi_noise_thresholdCmd;
+  delete sensor_max_stepCmd;
+  delete converter_max_stepCmd;
+  delete other_max_stepCmd;
+  delete sensor_prod_cutCmd;
+  delete converter_prod_cutCmd;
+  delete stepDir;
+  
+  delete importance_slabsCmd;
+  delete importance_ratioCmd;
+  delete biasingDir;
   
   delete set_nb_of_stripsCmd;
   delete set_strip_pitchCmd;
@@ -642,6 +730,33 @@ void DetectorMessenger::SetNewValue(G4UIcommand* command,G4String newValue)
   if ( command == build_pixel_detCmd )
     detector->Set_pixel_det_build( build_pixel_detCmd->GetNewBoolValue(newValue) );
     
+  if ( command == sparse_digiCmd )
+    detector->Set_sparse_digitization( sparse_digiCmd->GetNewBoolValue(newValue) );
+    
+  if ( command == digi_noise_thresholdCmd )
+    detector->Set_digi_noise_threshold( digi_noise_thresholdCmd->GetNewDoubleValue(newValue) );
+    
+  if ( command == sensor_max_stepCmd )
+    detector->Set_sensor_max_step( sensor_max_stepCmd->GetNewDoubleValue(newValue) );
+    
+  if ( command == converter_max_stepCmd )
+    detector->Set_converter_max_step( converter_max_stepCmd->GetNewDoubleValue(newValue) );
+    
+  if ( command == other_max_stepCmd )
+    detector->Set_other_max_step( other_max_stepCmd->GetNewDoubleValue(newValue) );
+    
+  if ( command == sensor_prod_cutCmd )
+    detector->Set_sensor_prod_cut( sensor_prod_cutCmd->GetNewDoubleValue(newValue) );
+    
+  if ( command == converter_prod_cutCmd )
+    detector->Set_converter_prod_cut( converter_prod_cutCmd->GetNewDoubleValue(newValue) );
+    
+  if ( command == importance_slabsCmd )
+    detector->Set_importance_slabs( importance_slabsCmd->GetNewIntValue(newValue) );
+    
+  if ( command == importance_ratioCmd )
+    detector->Set_importance_ratio( importance_ratioCmd->GetNewDoubleValue(newValue) );
+    
   if ( command == updateCmd ) detector->UpdateGeometry();
     
   if ( command == set_nb_of_stripsCmd )
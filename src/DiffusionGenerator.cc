@@ -6,8 +6,7 @@
 #include <iostream>
 #include <assert.h>
 #include <algorithm>
-
-#include "TrackerGeometry.hh"
+#include <cmath>
 
 DiffusionGenerator::DiffusionGenerator()
 {
@@ -19,32 +18,62 @@ DiffusionGenerator::DiffusionGenerator()
     det_thickness = 0.150;              // default det. thickness
     d = det_thickness*det_thickness;    // depth, set as det thickness^2 as good approximation
     sigma = sqrt((2*k*T*d*d)/(e*Vb));
+    build_kernel();
+}
+
+// The thickness is passed by the digitizer, which takes it from DetectorConstruction, so that
+// /det/digi/bias does not need to read the geometry from a macro file
+DiffusionGenerator::DiffusionGenerator(const double& bias, const double& thickness)
+{
+    //Calculate charge diffusion sigma
+    k = 1.3806488e-23;
+    T = 300;
+    Vb = bias;
+    e = 1.6e-19;
+    det_thickness = thickness;
+    // depth, set as det thickness^2 as good approximation
+    d = det_thickness*det_thickness;
+    sigma = ( bias <= 0. ) ? 0 : sqrt((2*k*T*d*d)/(e*Vb));
+    build_kernel();
 }
 
-// Use dedicated tracker geom object instead of passing one from SiDigitizer
-// as this allows the diffusion generator to be initialised with a single
-// variable from the messenger classes and macros compare with noise,
-// pedestal and cross talk functions
-DiffusionGenerator::DiffusionGenerator(const double& bias) : Vb(bias),
-tracker( std::string("tracker_geom.mac") )
+DiffusionGenerator::~DiffusionGenerator()
 {
-    if ( bias <= 0. ){sigma = 0;}
-    else
+    
+}
+
+void DiffusionGenerator::build_kernel()
+{
+    //No diffusion: the whole charge stays on the hit strip (step function)
+    kernel.clear();
+    kernel_x0 = 0;
+    kernel_inv_step = 0;
+    if ( !(sigma > 0) ) return;
+    
+    //Beyond 6 sigma the fraction is 0 or 1 to better than 1e-9. With 2048 bins the linear
+    //interpolation error is about 1e-6, well under the charge sharing threshold of get_charge_frac()
+    const int nBins = 2048;
+    const double range = 6*sigma;
+    kernel_x0 = -range;
+    kernel_inv_step = nBins/(2*range);
+    
+    kernel.resize(nBins+1);
+    const double norm = 1/(sigma*sqrt(2));
+    for ( int i = 0 ; i <= nBins ; ++i )
     {
-        //Calculate charge diffusion sigma
-        k = 1.3806488e-23;
-        T = 300;
-        e = 1.6e-19;
-        det_thickness = tracker.get_thickness();
-        // depth, set as det thickness^2 as good approximation
-        d = det_thickness*det_thickness;
-        sigma = sqrt((2*k*T*d*d)/(e*Vb));
+        kernel[i] = 0.5*(1+TMath::Erf((kernel_x0 + i/kernel_inv_step)*norm));
     }
 }
 
-DiffusionGenerator::~DiffusionGenerator()
+inline double DiffusionGenerator::get_edge_frac(double x) const
 {
+    if ( kernel.empty() ) return ( x >= 0 ) ? 1 : 0;
     
+    const double u = (x - kernel_x0)*kernel_inv_step;
+    if ( u <= 0 ) return 0;
+    const int i = static_cast<int>(u);
+    if ( i >= static_cast<int>(kernel.size()) - 1 ) return 1;
+    return kernel[i] + (kernel[i+1] - kernel[i])*(u - i);
 }
 
 double* DiffusionGenerator::get_igral_limits(double limits[], double det_strip_origin, double det_hit_pos, double s_pitch)
@@ -57,14 +86,14 @@ double* DiffusionGenerator::get_igral_limits(double limits[], double det_strip_o
     return limits;
 }
 
-double DiffusionGenerator::get_charge_frac(double limits[])
+double DiffusionGenerator::get_charge_frac(double limits[]) const
 {
     //Integrate the charge distribution (gaussian) over the limits set
     //by the strip pitch to determine what fraction of charge belongs
     //on the strip. The integral of a gaussian is the error function,
     //constants added so that it runs from 0 - 1.
     
-    double val_l, val_h, erf_val_l, erf_val_h, fraction, thr;
+    double erf_val_l, erf_val_h, fraction, thr;
     
     //Set charge sharing threshold so that computation time is reduced
     //prevents calculation for insignifcant amounts of charge sharing
@@ -72,18 +101,15 @@ double DiffusionGenerator::get_charge_frac(double limits[])
     //minimun of ~10e- on a strip.
     thr = 1e-4;
     
-    val_l = (limits[0])/(sigma*sqrt(2));
-    val_h = (limits[1])/(sigma*sqrt(2));
-    erf_val_l = 0.5*(1+TMath::Erf(val_l));
-    erf_val_h = 0.5*(1+TMath::Erf(val_h));
+    //0.5*(1+erf(limit/(sigma*sqrt(2)))), tabulated by build_kernel()
+    erf_val_l = get_edge_frac(limits[0]);
+    erf_val_h = get_edge_frac(limits[1]);
     
     fraction = ( (erf_val_h - erf_val_l) >= thr ) ? (erf_val_h - erf_val_l) : 0;
     
     //Use for debug
     /*std::cout << "\nlimits[0] = " << limits[0] << " mm" << std::endl;
     std::cout << "limits[1] = " << limits[1] << " mm" << std::endl;
-    std::cout << "val_l  = " << val_l  << std::endl;
-    std::cout << "val_h  = " << val_h  << std::endl;
     std::cout << "erf_val_l   = " << erf_val_l   << std::endl;
     std::cout << "erf_val_h  = " << erf_val_h  << std::endl;
     std::cout << "fraction of seed charge on current strip is: " << fraction << std::endl;*/
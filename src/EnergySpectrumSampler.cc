@@ -0,0 +1,163 @@
+
+#include "EnergySpectrumSampler.hh"
+
+#include "Randomize.hh"
+#include "G4Exception.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+EnergySpectrumSampler::EnergySpectrumSampler() :
+    useSpline(false),
+    nBins(10000),
+    eMin(0),
+    binWidth(0),
+    tableReady(false)
+{}
+
+G4bool EnergySpectrumSampler::LoadFile( const G4String& fileName )
+{
+    std::ifstream in( fileName.c_str() );
+    if ( !in.good() )
+    {
+        G4cerr << "Error opening the energy spectrum file: " << fileName << G4endl;
+        return false;
+    }
+    
+    std::vector<G4double> energies, intensities;
+    std::string line;
+    while ( std::getline( in, line ) )
+    {
+        size_t comment = line.find('#');
+        if ( comment != std::string::npos ) {line.erase(comment);}
+        std::istringstream fields( line );
+        G4double e, w;
+        if ( fields >> e >> w ) {energies.push_back( e*MeV ); intensities.push_back( w );}
+    }
+    
+    if ( energies.size() < 2 )
+    {
+        G4cerr << "Energy spectrum file " << fileName << " needs at least two points" << G4endl;
+        return false;
+    }
+    for ( size_t i = 1 ; i < energies.size() ; ++i )
+    {
+        if ( energies[i] <= energies[i-1] )
+        {
+            G4cerr << "Energy spectrum file " << fileName << ": energies must be increasing" << G4endl;
+            return false;
+        }
+    }
+    
+    points_E.swap( energies );
+    points_I.swap( intensities );
+    tableReady = false;
+    
+    G4cout << "\nEnergy spectrum: " << points_E.size() << " points from " << fileName << " ("
+           << points_E.front()/MeV << " - " << points_E.back()/MeV << " MeV)" << G4endl;
+    return true;
+}
+
+G4double EnergySpectrumSampler::Interpolate( G4double e ) const
+{
+    size_t i = std::upper_bound( points_E.begin(), points_E.end(), e ) - points_E.begin();
+    if ( i == 0 ) {return points_I.front();}
+    if ( i >= points_E.size() ) {return points_I.back();}
+    
+    G4double h = points_E[i] - points_E[i-1];
+    G4double a = ( points_E[i] - e )/h;
+    G4double b = 1. - a;
+    G4double value = a*points_I[i-1] + b*points_I[i];
+    if ( useSpline )
+    {
+        value += ( (a*a*a - a)*secondDerivatives[i-1] + (b*b*b - b)*secondDerivatives[i] )*h*h/6.;
+    }
+    // The spline can undershoot between points, a density is never negative
+    return std::max( value, 0. );
+}
+
+G4bool EnergySpectrumSampler::BuildTable()
+{
+    if ( tableReady ) return true;
+    if ( !IsLoaded() ) return false;
+    
+    // Natural cubic spline: second derivatives from the tridiagonal system
+    const size_t n = points_E.size();
+    secondDerivatives.assign( n, 0. );
+    if ( useSpline && n > 2 )
+    {
+        std::vector<G4double> u( n, 0. );
+        for ( size_t i = 1 ; i < n-1 ; ++i )
+        {
+            G4double sig = ( points_E[i] - points_E[i-1] )/( points_E[i+1] - points_E[i-1] );
+            G4double p = sig*secondDerivatives[i-1] + 2.;
+            secondDerivatives[i] = ( sig - 1. )/p;
+            u[i] = ( points_I[i+1] - points_I[i] )/( points_E[i+1] - points_E[i] )
+                 - ( points_I[i] - points_I[i-1] )/( points_E[i] - points_E[i-1] );
+            u[i] = ( 6.*u[i]/( points_E[i+1] - points_E[i-1] ) - sig*u[i-1] )/p;
+        }
+        secondDerivatives[n-1] = 0.;
+        for ( size_t k = n-1 ; k-- > 0 ; )
+        {
+            secondDerivatives[k] = secondDerivatives[k]*secondDerivatives[k+1] + u[k];
+        }
+    }
+    
+    // Bin probabilities (Simpson's rule on each bin)
+    eMin = points_E.front();
+    binWidth = ( points_E.back() - eMin )/nBins;
+    std::vector<G4double> prob( nBins );
+    G4double sum = 0.;
+    for ( G4int i = 0 ; i < nBins ; ++i )
+    {
+        G4double e0 = eMin + i*binWidth;
+        prob[i] = Interpolate( e0 ) + 4.*Interpolate( e0 + 0.5*binWidth ) + Interpolate( e0 + binWidth );
+        sum += prob[i];
+    }
+    if ( sum <= 0. )
+    {
+        G4cerr << "Energy spectrum has no positive intensity, alias table not built" << G4endl;
+        return false;
+    }
+    
+    // Walker/Vose alias table: bins with probability above average give their excess to
+    // the ones below, every bin ends up holding exactly the average probability
+    aliasProb.assign( nBins, 1. );
+    alias.resize( nBins );
+    std::vector<G4int> small, large;
+    for ( G4int i = 0 ; i < nBins ; ++i )
+    {
+        prob[i] *= nBins/sum;
+        alias[i] = i;
+        if ( prob[i] < 1. ) small.push_back(i);
+        else large.push_back(i);
+    }
+    while ( !small.empty() && !large.empty() )
+    {
+        G4int s = small.back(); small.pop_back();
+        G4int l = large.back();
+        aliasProb[s] = prob[s];
+        alias[s] = l;
+        prob[l] -= 1. - prob[s];
+        if ( prob[l] < 1. ) {large.pop_back(); small.push_back(l);}
+    }
+    // Left overs are 1 up to rounding
+    
+    tableReady = true;
+    return true;
+}
+
+G4double EnergySpectrumSampler::Sample() const
+{
+    if ( !tableReady )
+    {
+        G4Exception("EnergySpectrumSampler::Sample()", "pstepGun003", FatalException,
+                    "Energy spectrum sampled before its alias table was built");
+    }
+    G4double x = G4UniformRand()*nBins;
+    G4int bin = std::min( static_cast<G4int>(x), nBins-1 );
+    if ( x - bin >= aliasProb[bin] ) {bin = alias[bin];}
+    return eMin + ( bin + G4UniformRand() )*binWidth;
+}
@@ -7,11 +7,15 @@
 #include "SiHit.hh"
 #include "SiDigitizer.hh"
 #include "DetectorConstruction.hh"
+#include "ProgressMeter.hh"
+#include "DetectorPlanes.hh"
+#include "PrimaryGeneratorAction.hh"
 
 #include "G4HCofThisEvent.hh"
 #include "G4SDManager.hh"
 #include "G4DigiManager.hh"
 #include "G4Event.hh"
+#include "G4RunManager.hh"
 
 #include "G4TrackingManager.hh"
 #include "G4EventManager.hh"
@@ -25,15 +29,8 @@
 
 EventAction::EventAction(DetectorConstruction* myDC) :
 	rootSaver(0),
-    // N.B. these names must match those given for SD's
-    // in DetectorConstruction.cc
-    hitsCollName_x1("SiStrip_x1") ,
-    hitsCollName_u1("SiStrip_u1") ,
-    hitsCollName_v1("SiStrip_v1") ,
-    hitsCollName_pix1("SiPixel_pix1") ,
-    hitsCollName_pix2("SiPixel_pix2") ,
-    hitsCollName_pix3("SiPixel_pix3") ,
-    hitsCollName_pix4("SiPixel_pix4") ,
+    // N.B. the hits collection names come from DetectorPlanes and
+    // must match those given for SD's in DetectorConstruction.cc
 
 	digitsCollName("SiDigitCollection"),
     digitsCollName_pix("SiDigitCollection_pix"),
@@ -61,12 +58,11 @@ EventAction::EventAction(DetectorConstruction* myDC) :
 }
 
 
-void EventAction::BeginOfEventAction(const G4Event* anEvent )
+void EventAction::BeginOfEventAction(const G4Event* /*anEvent*/ )
 {
-	//if ( anEvent->GetEventID() % 1000 == 0 )
-	//{
-		G4cout << "\nStarting Event: " << anEvent->GetEventID() << G4endl;
-	//}
+	// No per-event printout (it flushes G4cout every event), the run
+	// progress is reported by ProgressMeter (/det/progress/interval)
+	//G4cout << "\nStarting Event: " << anEvent->GetEventID() << G4endl;
 }
 
 void EventAction::EndOfEventAction(const G4Event* anEvent)
@@ -79,7 +75,8 @@ void EventAction::EndOfEventAction(const G4Event* anEvent)
 	SiDigitizer* digiModule = static_cast<SiDigitizer*>( digiManager->FindDigitizerModule("SiDigitizer") );
     SiDigitizer_pix* digiModule_pix = static_cast<SiDigitizer_pix*>( digiManager->FindDigitizerModule("SiDigitizer_pix") );
 
-    if(anEvent->GetEventID() == 0) // only necessary to reset the value once at first event
+    // Re-set for every event: in MT mode event 0 is processed by one worker only,
+    // and each worker owns its own digitizer modules. These are just a few assignments.
     {
         // Used for re-setting the no. of planes and strips in case they have been changed from the default
         // vaules set in DetectorConstruction.cc by the .mac file. Necessary because DetectorConsturcion object with
@@ -88,232 +85,123 @@ void EventAction::EndOfEventAction(const G4Event* anEvent)
         // This then creates an error if the .mac file alters these parameters and recompiles the DetectorConstruction object.
         digiModule->ReSetDigiCollectionStrips( myDetector->Get_nb_of_strips() );
         digiModule->ReSetDigiCollectionPlanes( myDetector->Get_nb_of_planes() );
+        stripPlanePositions.clear();
+        stripPlaneAngles.clear();
+        G4ThreeVector planePos;
+        G4double planeAngle;
+        for ( G4int plane = 0 ; plane < myDetector->Get_nb_of_planes() && myDetector->Get_strip_plane_placement( plane, planePos, planeAngle ) ; ++plane )
+        {
+            stripPlanePositions.push_back( planePos );
+            stripPlaneAngles.push_back( planeAngle );
+        }
+        digiModule->ReSetSensorGeometry( myDetector->Get_nb_of_strips(), myDetector->Get_strip_pitch(),
+                                         myDetector->Get_strip_length(), myDetector->Get_sensor_thickness(),
+                                         stripPlanePositions, stripPlaneAngles );
         
         digiModule_pix->ReSetDigiCollectionPixels( myDetector->Get_nb_of_pixels() );
         digiModule_pix->ReSetDigiCollectionPlanes( myDetector->Get_nb_of_pix_planes() );
+        
+        digiModule->SetSparseDigitization( myDetector->Get_sparse_digitization() );
+        digiModule->SetNoiseThreshold( myDetector->Get_digi_noise_threshold() );
+        digiModule_pix->SetSparseDigitization( myDetector->Get_sparse_digitization() );
+        digiModule_pix->SetNoiseThreshold( myDetector->Get_digi_noise_threshold() );
     }
     
 	if ( digiModule )       {digiModule->Digitize();}
     if ( digiModule_pix )   {digiModule_pix->Digitize();}
 
+    // The phase-space replay can leave an event without any primary vertex
+    // (file exhausted or all particles skipped): nothing to store then
+    const G4bool hasPrimary = ( anEvent->GetNumberOfPrimaryVertex() > 0 );
+
+    // Event weight: the vertex weight of the (direction biased) source, 1 otherwise.
+    // A replayed event holds one vertex per phase-space record, each with its own
+    // first stage weight; those go to the tracks, hence to weight_pix<N>, so the
+    // event itself keeps weight 1.
+    const PrimaryGeneratorAction* primaryGenerator = static_cast<const PrimaryGeneratorAction*>(
+        G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction() );
+    const G4bool replay = primaryGenerator && primaryGenerator->IsReplayingPhaseSpace();
+    const G4float weight = ( hasPrimary && !replay ) ? anEvent->GetPrimaryVertex()->GetWeight() : 1.;
+
 	//Store information from strip detectors
-	if ( rootSaver && myDetector->Get_build_strip_detectors() )
+	if ( rootSaver && hasPrimary && myDetector->Get_build_strip_detectors() )
 	{
 		//Retrieve digits collection
-		static G4int digiCollID = -1;
+		static G4ThreadLocal G4int digiCollID = -1;
 		if ( digiCollID < 0 ) {digiCollID = digiManager->GetDigiCollectionID( digitsCollName );}
 		
         G4DCofThisEvent* digitsCollections = anEvent->GetDCofThisEvent();
 		SiDigiCollection* digits = 0;
 		if ( digitsCollections ) {digits = static_cast<SiDigiCollection*>( digitsCollections->GetDC(digiCollID) );}
         
-		//Retrieve hits collections
-		static G4int hitsCollID_x1 = -1;
-		static G4int hitsCollID_u1 = -1;
-		static G4int hitsCollID_v1 = -1;
-        
-		if ( hitsCollID_x1 < 0 )
-		{
-			// Also the following line works:
-			// hitsCollID_1 = digiManager->GetHitsCollectionID(hitscollname_SD1);
-			// But we prefer to show here a (longer) version, in case no digiManager is used
-			G4SDManager * SDman = G4SDManager::GetSDMpointer();
-            
-			hitsCollID_x1 = SDman->GetCollectionID(hitsCollName_x1);
-			hitsCollID_u1 = SDman->GetCollectionID(hitsCollName_u1);
-			hitsCollID_v1 = SDman->GetCollectionID(hitsCollName_v1);
-		}
-        
+		//Retrieve hits collections, one per plane
+		UpdateHitsCollectionIDs( hitsCollIDs_strip, myDetector->Get_nb_of_planes(), false );
 		G4HCofThisEvent* HCE = anEvent->GetHCofThisEvent();
-        
-        //int n_hit = HCE->GetCapacity();
-        //G4cout << "x1 has " << n_hit << " hits." << G4endl;
-        
-		SiHitCollection* hits_x1 = 0;
-		SiHitCollection* hits_u1 = 0;
-		SiHitCollection* hits_v1 = 0;
-        
-		if ( HCE )
+		std::vector<const SiHitCollection*> hits( hitsCollIDs_strip.size(), static_cast<const SiHitCollection*>(0) );
+		for ( size_t plane = 0 ; HCE && plane < hits.size() ; ++plane )
 		{
-            //G4cout << "about to static cast for hitsCollID_x1 = " << hitsCollID_x1 << ", for hitsCollName_x1 = " << hitsCollName_x1 << G4endl;
-			hits_x1 = static_cast<SiHitCollection*>( HCE->GetHC(hitsCollID_x1) );
-			hits_u1 = static_cast<SiHitCollection*>( HCE->GetHC(hitsCollID_u1) );
-			hits_v1 = static_cast<SiHitCollection*>( HCE->GetHC(hitsCollID_v1) );
+			if ( hitsCollIDs_strip[plane] >= 0 ) {hits[plane] = static_cast<const SiHitCollection*>( HCE->GetHC(hitsCollIDs_strip[plane]) );}
 		}
         
-        //Enable for printouts
-        
-        
-//        if(hits_x1)
-//        {
-//            int n_hit = hits_x1->entries();
-//            G4cout << "x1 has " << n_hit << " hits." << G4endl;
-//            for(int i1=0;i1<n_hit;i1++)
-//            {
-//                SiHit* aHit = (*hits_x1)[i1];
-//                if(aHit->GetNonIonisingEdep()>0) aHit->Print();
-//            }
-//        }
-//        
-//        
-//        if(hits_u1)
-//        {
-//            int n_hit = hits_u1->entries();
-//            G4cout << "u1 has " << n_hit << " hits." << G4endl;
-//            for(int i1=0;i1<n_hit;i1++)
-//            {
-//                SiHit* aHit = (*hits_u1)[i1];
-//                aHit->Print();
-//            }
-//        }
-//        
-//        if(hits_v1)
-//        {
-//            int n_hit = hits_v1->entries();
-//            G4cout << "v1 has " << n_hit << " hits." << G4endl;
-//            for(int i1=0;i1<n_hit;i1++)
-//            {
-//                SiHit* aHit = (*hits_v1)[i1];
-//                aHit->Print();
-//            }
-//        }
-        
-        
-        
-		//Get Postion and Momentum of primary
-		//This is needed to write to root file info @ z=0
 		const G4ThreeVector& pos = anEvent->GetPrimaryVertex()->GetPosition();
 		const G4ThreeVector& mom = anEvent->GetPrimaryVertex()->GetPrimary()->GetMomentum();
         const G4int event = anEvent->GetEventID();
         
-        //Getting KE at entrance and exit..
-        //G4float KE_out = 0; //now set in Rootsaver.cc using KE of primary hit in last tracking detector. 
         const G4float KE_in = anEvent->GetPrimaryVertex()->GetPrimary()->GetKineticEnergy();
-        
-        
-        // Save event to root file
-		if( myDetector->Get_build_strip_detectors() )
-        {rootSaver->AddEvent_strip_det(event, hits_x1, hits_u1, hits_v1, digits, pos, mom, KE_in/*,KE_out*/);} // initial/final particle info
-        
-		// Print information about hits. Hits container has a method:
-        // G4VHitsCollection::PrintAllHits() that
-		// recursively calls G4VHit::Print() method
-		
-		//hits_x1->PrintAllHits();
-		//hits_u1->PrintAllHits();
-		//hits_v1->PrintAllHits();
-    
-        // Printout disables for SiDigi now as noise on each strip for each event results in huge printout
-        //digits->PrintAllDigi();
-
+        rootSaver->AddEvent_strip_det(event, hits, digits, pos, mom, KE_in/*,KE_out*/, weight); // initial/final particle info
 	}
     
-    //Store information from strip detectors
-    if ( rootSaver && myDetector->Get_build_pixel_detectors() )
+    //Store information from pixel detectors
+    if ( rootSaver && hasPrimary && myDetector->Get_build_pixel_detectors() )
     {
         //Retrieve digits collection
-        static G4int digiCollID = -1;
+        static G4ThreadLocal G4int digiCollID = -1;
         if ( digiCollID < 0 ) {digiCollID = digiManager->GetDigiCollectionID( digitsCollName_pix );}
         
         G4DCofThisEvent * digitsCollections = anEvent->GetDCofThisEvent();
         SiDigi_pixCollection * digits = 0;
         if ( digitsCollections ) {digits = static_cast<SiDigi_pixCollection*>( digitsCollections->GetDC(digiCollID) );}
         
-        //Retrieve hits collections
-        static G4int hitsCollID_pix1 = -1;
-        static G4int hitsCollID_pix2 = -1;
-        static G4int hitsCollID_pix3 = -1;
-        static G4int hitsCollID_pix4 = -1;
-        
-        if ( hitsCollID_pix1 < 0 )
-        {
-            // Also the following line works:
-            // hitsCollID_1 = digiManager->GetHitsCollectionID(hitscollname_SD1);
-            // But we prefer to show here a (longer) version, in case no digiManager is used
-            G4SDManager * SDman = G4SDManager::GetSDMpointer();
-            //G4cout << "\nHere's a list of the names of SD's registered: " << G4endl; SDman->ListTree();
-            hitsCollID_pix1 = SDman->GetCollectionID(hitsCollName_pix1);
-            hitsCollID_pix2 = SDman->GetCollectionID(hitsCollName_pix2);
-            hitsCollID_pix3 = SDman->GetCollectionID(hitsCollName_pix3);
-            hitsCollID_pix4 = SDman->GetCollectionID(hitsCollName_pix4);
-            
-            //G4cout << "\nThe name and ID feched were hitsCollName_pix1: " << hitsCollName_pix1;
-            //G4cout << " and hitsCollID_pix1: " << hitsCollID_pix1 << G4endl;
-        }
-        
+        //Retrieve hits collections, one per plane
+        UpdateHitsCollectionIDs( hitsCollIDs_pix, myDetector->Get_nb_of_pix_planes(), true );
         G4HCofThisEvent* HCE = anEvent->GetHCofThisEvent();
-        //G4cout << "\nHCE->GetNumberOfCollections() =  " << HCE->GetNumberOfCollections() << "\n" << G4endl;
-        //G4cout << "\npix1 (HCE->GetCapacity()) has " << HCE->GetCapacity() << " hits.\n" << G4endl;
-        
-        SiHit_pixCollection * hits_pix1 = 0;
-        SiHit_pixCollection * hits_pix2 = 0;
-        SiHit_pixCollection * hits_pix3 = 0;
-        SiHit_pixCollection * hits_pix4 = 0;
-
-        if ( HCE )
+        std::vector<const SiHit_pixCollection*> hits( hitsCollIDs_pix.size(), static_cast<const SiHit_pixCollection*>(0) );
+        for ( size_t plane = 0 ; HCE && plane < hits.size() ; ++plane )
         {
-            //G4cout << "about to static cast for hitsCollID_pix1 = " << hitsCollID_pix1;
-            //G4cout << ", for hitsCollName_pix1 = " << hitsCollName_pix1 << G4endl;
-            hits_pix1 = static_cast<SiHit_pixCollection*>( HCE->GetHC(hitsCollID_pix1) );
-            hits_pix2 = static_cast<SiHit_pixCollection*>( HCE->GetHC(hitsCollID_pix2) );
-            hits_pix3 = static_cast<SiHit_pixCollection*>( HCE->GetHC(hitsCollID_pix3) );
-            hits_pix4 = static_cast<SiHit_pixCollection*>( HCE->GetHC(hitsCollID_pix4) );
+            if ( hitsCollIDs_pix[plane] >= 0 ) {hits[plane] = static_cast<const SiHit_pixCollection*>( HCE->GetHC(hitsCollIDs_pix[plane]) );}
         }
         
-        //Enable for printouts
-        
-//        if(hits_pix1)
-//        {
-//            int n_hit = hits_pix1->entries();
-//            G4cout << "pix1 has " << n_hit << " hits." << G4endl;
-//            //if(n_hit > 0) {exit(-1);}
-//            for(int i1=0;i1<n_hit;i1++)
-//            {
-//                SiHit_pix * aHit = (*hits_pix1)[i1];
-//                /*if(aHit->GetNonIonisingEdep()>0)*/ aHit->Print();
-//            }
-//        }
-//
-//
-//        if(hits_pix2)
-//        {
-//            int n_hit = hits_pix2->entries();
-//            G4cout << "pix2 has " << n_hit << " hits." << G4endl;
-//            for(int i1=0;i1<n_hit;i1++)
-//            {
-//                SiHit_pix * aHit = (*hits_pix2)[i1];
-//                aHit->Print();
-//            }
-//        }
-
-        
-        // Get Postion and Momentum of primary
-        // This is needed to write to root file info @ z=0
         const G4ThreeVector& pos = anEvent->GetPrimaryVertex()->GetPosition();
         const G4ThreeVector& mom = anEvent->GetPrimaryVertex()->GetPrimary()->GetMomentum();
         const G4int event = anEvent->GetEventID();
 
-        // Getting KE at entrance and exit..
-        //G4float KE_out = 0; //now set in Rootsaver.cc using KE of primary hit in last tracking detector.
         const G4float KE_in = anEvent->GetPrimaryVertex()->GetPrimary()->GetKineticEnergy();
-
-        // Save event to root file
-        if( myDetector->Get_build_pixel_detectors() )
-        {rootSaver->AddEvent_pixel_det(event, hits_pix1, hits_pix2, hits_pix3, hits_pix4, digits, pos, mom, KE_in/*,KE_out*/);} // initial/final particle info
-        
-        // Print information about hits. Hits container has a method:
-        // G4VHitsCollection::PrintAllHits() that
-        // recursively calls G4VHit::Print() method
-        
-        //hits_pix1->PrintAllHits();
-        //hits_pix2->PrintAllHits();
-        //hits_pix3->PrintAllHits();
-        //hits_pix4->PrintAllHits();
-        
-        // Printout disables for SiDigi now as noise on each strip for each event results in huge printout
-        //digits->PrintAllDigi();
-        
+        rootSaver->AddEvent_pixel_det(event, hits, digits, pos, mom, KE_in/*,KE_out*/, weight); // initial/final particle info
     }
+    
+    G4bool hasHits = false;
+    G4HCofThisEvent* HCE = anEvent->GetHCofThisEvent();
+    if ( HCE )
+    {
+        for ( G4int i = 0 ; i < HCE->GetNumberOfCollections() && !hasHits ; ++i )
+        {
+            G4VHitsCollection* hc = HCE->GetHC(i);
+            hasHits = ( hc && hc->GetSize() > 0 );
+        }
+    }
+    ProgressMeter::EventDone( hasHits );
 
 }
 
+void EventAction::UpdateHitsCollectionIDs( std::vector<G4int>& ids, const G4int nPlanes, const G4bool pixels )
+{
+    // Looked up once (and again if the no. of planes changes), -1 for a plane without SD
+    if ( static_cast<G4int>( ids.size() ) == nPlanes ) {return;}
+    G4SDManager * SDman = G4SDManager::GetSDMpointer();
+    ids.assign( nPlanes, -1 );
+    for ( G4int plane = 0 ; plane < nPlanes ; ++plane )
+    {
+        const G4String name = pixels ? DetectorPlanes::PixelHitsCollectionName(plane) : DetectorPlanes::StripHitsCollectionName(plane);
+        ids[plane] = SDman->GetCollectionID( name );
+    }
+}
@@ -0,0 +1,82 @@
+
+#include "EventSeeder.hh"
+
+#include "G4Event.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "Randomize.hh"
+
+#include <sstream>
+
+G4long EventSeeder::runSeed = 0;
+G4int EventSeeder::replayRunID = -1;
+G4int EventSeeder::replayEventID = -1;
+
+namespace
+{
+    // SplitMix64 finaliser: a bijective mix of the 64 bit counter
+    inline unsigned long long SplitMix64( unsigned long long x )
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = ( x ^ ( x >> 30 ) )*0xBF58476D1CE4E5B9ULL;
+        x = ( x ^ ( x >> 27 ) )*0x94D049BB133111EBULL;
+        return x ^ ( x >> 31 );
+    }
+}
+
+EventSeeder::EventSeeder( G4long seed )
+{
+    runSeed = seed;
+    G4cout << "\nRun seed: " << runSeed << " (pstep -s " << runSeed << " reproduces every event)\n" << G4endl;
+    
+    randomDir = new G4UIdirectory("/det/random/");
+    randomDir->SetGuidance("per-event seeding derived from the run seed (pstep -s)");
+    
+    replayCmd = new G4UIcmdWithAString("/det/random/replay",this);
+    replayCmd->SetGuidance("Seed the events of the next run as event <eventID>, <eventID>+1, ... of run <runID>:");
+    replayCmd->SetGuidance("/det/random/replay 3 1234 then /run/beamOn 1 regenerates event 1234 of run 3.");
+    replayCmd->SetGuidance("\"off\" (default) uses the actual run and event IDs.");
+    replayCmd->SetParameterName("runID_eventID",false);
+    replayCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+    // The values are shared with the workers, set them only once on the master
+    replayCmd->SetToBeBroadcasted(false);
+}
+
+EventSeeder::~EventSeeder()
+{
+    delete replayCmd;
+    delete randomDir;
+}
+
+void EventSeeder::SetNewValue( G4UIcommand* cmd, G4String newValue )
+{
+    if ( cmd == replayCmd )
+    {
+        std::istringstream is( newValue );
+        G4int run = -1, event = -1;
+        if ( newValue == "off" || !( is >> run >> event ) ) {run = -1; event = -1;}
+        replayRunID = run;
+        replayEventID = event;
+    }
+}
+
+void EventSeeder::SeedEvent( const G4Event* anEvent )
+{
+    G4int runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+    G4int eventID = anEvent->GetEventID();
+    if ( replayRunID >= 0 ) {runID = replayRunID; eventID += replayEventID;}
+    
+    // Counter = (run ID, event ID), key = run seed
+    unsigned long long counter = ( static_cast<unsigned long long>( static_cast<unsigned int>(runID) ) << 32 )
+                               | static_cast<unsigned int>(eventID);
+    unsigned long long key = SplitMix64( static_cast<unsigned long long>(runSeed) ^ SplitMix64( counter ) );
+    
+    // Two seeds in the ranges accepted by RanecuEngine (also fine for the other engines)
+    long seeds[3];
+    seeds[0] = static_cast<long>( SplitMix64( key ) % 2147483562ULL ) + 1;
+    seeds[1] = static_cast<long>( SplitMix64( key + 1 ) % 2147483398ULL ) + 1;
+    seeds[2] = 0;
+    G4Random::setTheSeeds( seeds );
+}
@@ -0,0 +1,66 @@
+
+#include "FastSource.hh"
+
+#include "G4Event.hh"
+#include "G4ParticleGun.hh"
+#include "G4ParticleTable.hh"
+#include "Randomize.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+
+// Defaults are the ones of the GPS in PrimaryGeneratorAction::InitializeGPS()
+FastSource::FastSource() :
+    G4VPrimaryGenerator(),
+    centre(0.,0.,0.),
+    axis(0.,0.,1.),
+    diskRadius(0.),
+    angularType(beam2d),
+    beamSigmaX(7.3*mrad),
+    beamSigmaY(7.3*mrad)
+{
+    particleGun = new G4ParticleGun(1);
+    particleGun->SetParticleDefinition( G4ParticleTable::GetParticleTable()->FindParticle("proton") );
+    particleGun->SetParticleEnergy( 190.8*MeV );
+}
+
+FastSource::~FastSource()
+{
+    delete particleGun;
+}
+
+void FastSource::GeneratePrimaryVertex( G4Event* anEvent )
+{
+    // Position
+    G4ThreeVector position = centre;
+    if ( diskRadius > 0. )
+    {
+        G4double r = diskRadius*std::sqrt( G4UniformRand() );
+        G4double phi = twopi*G4UniformRand();
+        G4ThreeVector offset( r*std::cos(phi), r*std::sin(phi), 0. );
+        position += offset.rotateUz( axis );
+    }
+    
+    // Direction
+    G4ThreeVector direction = axis;
+    if ( angularType == iso )
+    {
+        G4double cosTheta = 2.*G4UniformRand() - 1.;
+        G4double sinTheta = std::sqrt( 1. - cosTheta*cosTheta );
+        G4double phi = twopi*G4UniformRand();
+        direction.set( sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta );
+    }
+    else if ( angularType == beam2d )
+    {
+        G4double thetaX = G4RandGauss::shoot( 0., beamSigmaX );
+        G4double thetaY = G4RandGauss::shoot( 0., beamSigmaY );
+        direction.set( std::tan(thetaX), std::tan(thetaY), 1. );
+        direction = direction.unit().rotateUz( axis );
+    }
+    
+    particleGun->SetParticlePosition( position );
+    particleGun->SetParticleMomentumDirection( direction );
+    particleGun->GeneratePrimaryVertex( anEvent );
+}
@@ -0,0 +1,108 @@
+
+#include "ImportanceWorld.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4IStore.hh"
+#include "G4GeometryCell.hh"
+#include "G4AutoLock.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace { G4Mutex importanceStoreMutex = G4MUTEX_INITIALIZER; }
+
+ImportanceWorld::ImportanceWorld( const G4String& worldName, DetectorConstruction* myDC ) :
+    G4VUserParallelWorld(worldName),
+    myDetector(myDC),
+    ghostWorld(0),
+    nSlabCells(0)
+{}
+
+void ImportanceWorld::Construct()
+{
+    ghostWorld = GetWorld();
+    G4LogicalVolume* ghostWorldLogical = ghostWorld->GetLogicalVolume();
+    cells.clear();
+    
+    // World position of the shields: the PE shield is placed inside the phantom,
+    // the Pb one directly in the world. Only rotations around z are used in the geometry.
+    G4double phantomTheta = myDetector->Get_PhantomAngle();
+    G4ThreeVector pos_shield = myDetector->Get_ShieldPosition();
+    pos_shield.rotateZ(-phantomTheta);
+    pos_shield += myDetector->Get_PhantomPosition();
+    G4ThreeVector pos_contact2 = myDetector->Get_Contact2Position();
+    
+    // Slabs are numbered along the beam so that the importance increases towards the converter
+    if ( pos_shield.z() < pos_contact2.z() )
+    {
+        BuildSlabs( pos_shield, phantomTheta+myDetector->Get_ShieldAngle(), myDetector->Get_halfShieldSizeXY(), myDetector->Get_halfShieldSizeZ(), ghostWorldLogical );
+        BuildSlabs( pos_contact2, myDetector->Get_Contact2Angle(), myDetector->Get_halfContact2SizeXY(), myDetector->Get_halfContact2SizeZ(), ghostWorldLogical );
+    }
+    else
+    {
+        BuildSlabs( pos_contact2, myDetector->Get_Contact2Angle(), myDetector->Get_halfContact2SizeXY(), myDetector->Get_halfContact2SizeZ(), ghostWorldLogical );
+        BuildSlabs( pos_shield, phantomTheta+myDetector->Get_ShieldAngle(), myDetector->Get_halfShieldSizeXY(), myDetector->Get_halfShieldSizeZ(), ghostWorldLogical );
+    }
+    
+    nSlabCells = cells.size();
+    
+    // Everything downstream of the last slab keeps its importance,
+    // otherwise the split neutrons would be killed again on leaving the shield
+    G4double zEnd = std::max( pos_shield.z() + myDetector->Get_halfShieldSizeZ(),
+                              pos_contact2.z() + myDetector->Get_halfContact2SizeZ() );
+    G4double halfWorldZ = myDetector->Get_halfWorldLengthZ();
+    G4double halfWorldXY = myDetector->Get_halfWorldLengthXY();
+    G4double halfBackZ = 0.5*( halfWorldZ - zEnd );
+    if ( halfBackZ > 0. )
+    {
+        G4Box* solidBack = new G4Box( "importanceBack", halfWorldXY, halfWorldXY, halfBackZ );
+        G4LogicalVolume* logicBack = new G4LogicalVolume( solidBack, 0, "ImportanceBack" );
+        cells.push_back( new G4PVPlacement( 0, G4ThreeVector( 0., 0., zEnd + halfBackZ ), logicBack,
+                                            "ImportanceBack", ghostWorldLogical, false, 0 ) );
+    }
+    
+    G4cout << "\nImportance biasing: " << cells.size() << " cells, importance ratio "
+           << myDetector->Get_importance_ratio() << " per slab\n" << G4endl;
+}
+
+void ImportanceWorld::BuildSlabs( const G4ThreeVector& pos, G4double theta, G4double halfXY, G4double halfZ, G4LogicalVolume* mother )
+{
+    G4int nSlabs = myDetector->Get_importance_slabs();
+    if ( nSlabs < 1 ) return;
+    
+    G4double halfSlabZ = halfZ/nSlabs;
+    G4Box* solidSlab = new G4Box( "importanceSlab", halfXY, halfXY, halfSlabZ );
+    G4LogicalVolume* logicSlab = new G4LogicalVolume( solidSlab, 0, "ImportanceSlab" );
+    for ( G4int i = 0 ; i < nSlabs ; ++i )
+    {
+        G4RotationMatrix* slab_rm = new G4RotationMatrix;
+        slab_rm->rotateZ(theta);
+        G4ThreeVector slabPos = pos + G4ThreeVector( 0., 0., -halfZ + (2*i+1)*halfSlabZ );
+        // Copy number is the cell index, each slab is its own physical volume (one geometry cell
+        // identified by the volume and its copy number)
+        cells.push_back( new G4PVPlacement( slab_rm, slabPos, logicSlab, "ImportanceSlab",
+                                            mother, false, cells.size() ) );
+    }
+}
+
+void ImportanceWorld::ConstructSD()
+{
+    // Called on every thread once the geometry exists: each thread has its own store
+    G4AutoLock lock(&importanceStoreMutex);
+    G4IStore* istore = G4IStore::GetInstance( GetName() );
+    istore->Clear();
+    
+    istore->AddImportanceGeometryCell( 1, *ghostWorld );
+    G4double ratio = myDetector->Get_importance_ratio();
+    for ( size_t i = 0 ; i < cells.size() ; ++i )
+    {
+        G4int n = std::min( static_cast<G4int>(i)+1, nSlabCells );
+        istore->AddImportanceGeometryCell( std::pow( ratio, static_cast<G4double>(n) ), *cells[i], cells[i]->GetCopyNo() );
+    }
+}
@@ -2,6 +2,7 @@
 #include "NoiseGenerator.hh"
 #include <assert.h>
 #include <algorithm>
+#include <cmath>
 
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
@@ -28,4 +29,34 @@ G4double NoiseGenerator::operator()()
      return 0.;
 }
 
+G4double NoiseGenerator::ProbabilityAbove(const G4double& threshold) const
+{
+	//Without smearing the noise is exactly 0
+	if ( sigma <= 0. )
+		return ( threshold < 0. ) ? 1. : 0.;
+	return 0.5*std::erfc( threshold/(sigma*std::sqrt(2.)) );
+}
 
+G4double NoiseGenerator::FireAbove(const G4double& threshold)
+{
+	if ( sigma <= 0. )
+		return 0.;
+	const G4double a = threshold/sigma;
+	if ( a <= 0. )
+	{
+		//At least half of the gaussian is above threshold: plain rejection
+		G4double x = randomGauss.fire( 0.0 , 1.0 );
+		while ( x <= a ) { x = randomGauss.fire( 0.0 , 1.0 ); }
+		return x*sigma;
+	}
+	//Far tail: exponential proposal with rejection (C.P. Robert, Stat. Comput. 5 (1995) 121)
+	const G4double lambda = 0.5*( a + std::sqrt( a*a + 4. ) );
+	G4double x, u;
+	do
+	{
+		x = a - std::log( 1. - G4UniformRand() )/lambda;
+		u = G4UniformRand();
+	}
+	while ( u > std::exp( -0.5*(x-lambda)*(x-lambda) ) );
+	return x*sigma;
+}
@@ -0,0 +1,127 @@
+
+#include "PhaseSpaceGenerator.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4IonTable.hh"
+#include "G4AutoLock.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+std::string PhaseSpaceGenerator::fileName = "";
+std::ifstream* PhaseSpaceGenerator::input = 0;
+PhaseSpaceHeader PhaseSpaceGenerator::header;
+PhaseSpaceRecord PhaseSpaceGenerator::nextRecord;
+G4bool PhaseSpaceGenerator::hasNextRecord = false;
+
+namespace { G4Mutex phaseSpaceInputMutex = G4MUTEX_INITIALIZER; }
+
+PhaseSpaceGenerator::PhaseSpaceGenerator() :
+    G4VPrimaryGenerator()
+{}
+
+G4bool PhaseSpaceGenerator::SetFileName( const G4String& name )
+{
+    // The command is broadcast to every worker, the first one opens the file
+    G4AutoLock lock(&phaseSpaceInputMutex);
+    if ( input && fileName == name ) {return true;}
+    
+    if ( input ) {input->close(); delete input; input = 0;}
+    fileName = name;
+    hasNextRecord = false;
+    
+    input = new std::ifstream( fileName.c_str(), std::ios::in | std::ios::binary );
+    if ( !input->read( reinterpret_cast<char*>(&header), sizeof(header) )
+         || std::string( header.magic ) != "PSTEPPS"
+         || header.recordSize != static_cast<G4int>( sizeof(PhaseSpaceRecord) ) )
+    {
+        G4cerr << "Error reading the phase-space file: " << fileName << G4endl;
+        delete input;
+        input = 0;
+        fileName = "";
+        return false;
+    }
+    
+    G4cout << "\nReplaying phase-space file: " << fileName << " " << header.nRecords << " particles from "
+           << header.nEvents << " first stage events (normalise the results to " << header.nEvents << " events)" << G4endl;
+    return true;
+}
+
+G4bool PhaseSpaceGenerator::ReadRecord( PhaseSpaceRecord& rec )
+{
+    return static_cast<bool>( input->read( reinterpret_cast<char*>(&rec), sizeof(rec) ) );
+}
+
+G4bool PhaseSpaceGenerator::Rewind()
+{
+    input->clear();
+    input->seekg( sizeof(PhaseSpaceHeader), std::ios::beg );
+    G4cout << "WARNING: end of the phase-space file " << fileName << " reached, rewinding: particles will be reused" << G4endl;
+    return ReadRecord( nextRecord );
+}
+
+size_t PhaseSpaceGenerator::ReadNextEvent( std::vector<PhaseSpaceRecord>& buffer )
+{
+    G4AutoLock lock(&phaseSpaceInputMutex);
+    buffer.clear();
+    if ( !input ) {return 0;}
+    
+    if ( !hasNextRecord )
+    {
+        hasNextRecord = ReadRecord( nextRecord ) || Rewind();
+        if ( !hasNextRecord ) {return 0;} // empty file
+    }
+    
+    // Records of one event are stored consecutively
+    G4int eventID = nextRecord.eventID;
+    do
+    {
+        buffer.push_back( nextRecord );
+        hasNextRecord = ReadRecord( nextRecord );
+    } while ( hasNextRecord && nextRecord.eventID == eventID );
+    
+    return buffer.size();
+}
+
+void PhaseSpaceGenerator::GeneratePrimaryVertex( G4Event* anEvent )
+{
+    if ( ReadNextEvent( eventRecords ) == 0 )
+    {
+        G4cerr << "No phase-space particles available, event " << anEvent->GetEventID() << " is aborted." << G4endl;
+        anEvent->SetEventAborted();
+        return;
+    }
+    
+    G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
+    for ( size_t i = 0 ; i < eventRecords.size() ; ++i )
+    {
+        const PhaseSpaceRecord& rec = eventRecords[i];
+        
+        G4ParticleDefinition* particle = particleTable->FindParticle( rec.pdgCode );
+        if ( !particle ) {particle = G4IonTable::GetIonTable()->GetIon( rec.pdgCode );}
+        if ( !particle )
+        {
+            G4cerr << "Unknown PDG code " << rec.pdgCode << " in the phase-space file, particle skipped." << G4endl;
+            continue;
+        }
+        
+        G4PrimaryVertex* vertex = new G4PrimaryVertex( G4ThreeVector( rec.x*mm, rec.y*mm, rec.z*mm ), rec.time*ns );
+        G4PrimaryParticle* primary = new G4PrimaryParticle( particle );
+        primary->SetKineticEnergy( rec.kineticEnergy*MeV );
+        primary->SetMomentumDirection( G4ThreeVector( rec.dx, rec.dy, rec.dz ).unit() );
+        vertex->SetPrimary( primary );
+        vertex->SetWeight( rec.weight );
+        anEvent->AddPrimaryVertex( vertex );
+    }
+    
+    if ( anEvent->GetNumberOfPrimaryVertex() == 0 )
+    {
+        G4cerr << "No known particle in phase-space event " << eventRecords[0].eventID << ", event "
+               << anEvent->GetEventID() << " is aborted." << G4endl;
+        anEvent->SetEventAborted();
+    }
+}
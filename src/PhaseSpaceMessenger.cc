@@ -0,0 +1,43 @@
+
+#include "PhaseSpaceMessenger.hh"
+#include "PhaseSpaceWriter.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
+
+PhaseSpaceMessenger::PhaseSpaceMessenger(PhaseSpaceWriter* phaseSpaceWriter) :
+	writer(phaseSpaceWriter)
+{
+	phaseSpaceDir = new G4UIdirectory("/det/phaseSpace/");
+	phaseSpaceDir->SetGuidance("commands related to the phase-space file at the converter/sensor boundary");
+
+	recordCmd = new G4UIcmdWithAString("/det/phaseSpace/record",this);
+	recordCmd->SetGuidance("Record every particle entering the converter film or the sensor planes");
+	recordCmd->SetGuidance("to <name>_run<N>.phsp (applied at the next /run/beamOn), none to stop recording.");
+	recordCmd->SetGuidance("Replay it with /det/gun/replayPhaseSpace <file>.");
+	recordCmd->SetParameterName("fileName",false);
+	recordCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	killRecordedCmd = new G4UIcmdWithABool("/det/phaseSpace/killRecorded",this);
+	killRecordedCmd->SetGuidance("Stop the tracks once they are recorded (default true), so that the first stage");
+	killRecordedCmd->SetGuidance("ends at the boundary and no particle is written twice.");
+	killRecordedCmd->SetParameterName("kill",true);
+	killRecordedCmd->SetDefaultValue(true);
+	killRecordedCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+}
+
+
+PhaseSpaceMessenger::~PhaseSpaceMessenger()
+{
+	delete recordCmd;
+	delete killRecordedCmd;
+	delete phaseSpaceDir;
+}
+
+void PhaseSpaceMessenger::SetNewValue(G4UIcommand* cmd,G4String newValue)
+{
+	if ( cmd == recordCmd )
+		writer->SetFileBaseName( newValue );
+	if ( cmd == killRecordedCmd )
+		writer->SetKillRecorded( killRecordedCmd->GetNewBoolValue(newValue) );
+}
@@ -0,0 +1,158 @@
+
+#include "PhaseSpaceWriter.hh"
+#include "PhaseSpaceMessenger.hh"
+
+#include "G4Track.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cstdio>
+#include <cstring>
+
+PhaseSpaceWriter::PhaseSpaceWriter() :
+    baseName(""),
+    killRecorded(true),
+    fileName(""),
+    output(0),
+    converterRegion(0),
+    sensorRegion(0),
+    messenger(0)
+{
+    messenger = new PhaseSpaceMessenger(this);
+}
+
+PhaseSpaceWriter::~PhaseSpaceWriter()
+{
+    if ( output ) {Close( header.nEvents );}
+    delete messenger;
+}
+
+void PhaseSpaceWriter::SetFileBaseName( const G4String& name )
+{
+    baseName = ( name == "none" ) ? G4String("") : name;
+}
+
+G4bool PhaseSpaceWriter::Open( const std::string& fName )
+{
+    if ( output ) {Close( header.nEvents );}
+    if ( !IsEnabled() ) {return false;}
+    
+    // Regions exist once the geometry is built
+    G4RegionStore* regionStore = G4RegionStore::GetInstance();
+    converterRegion = regionStore->GetRegion("ConverterRegion",false);
+    sensorRegion = regionStore->GetRegion("SensorRegion",false);
+    
+    output = new std::ofstream( fName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+    if ( !output->good() )
+    {
+        G4cerr << "Error opening the phase-space file: " << fName << G4endl;
+        delete output;
+        output = 0;
+        return false;
+    }
+    fileName = fName;
+    
+    std::memset( &header, 0, sizeof(header) );
+    std::strncpy( header.magic, "PSTEPPS", sizeof(header.magic) );
+    header.version = 1;
+    header.recordSize = sizeof(PhaseSpaceRecord);
+    WriteHeader();
+    
+    G4cout << "\nRecording phase space at the converter/sensor boundary to: " << fileName << G4endl;
+    return true;
+}
+
+void PhaseSpaceWriter::WriteHeader()
+{
+    output->seekp( 0 , std::ios::beg );
+    output->write( reinterpret_cast<const char*>(&header), sizeof(header) );
+    output->seekp( 0 , std::ios::end );
+}
+
+void PhaseSpaceWriter::Close( G4long nEvents )
+{
+    if ( !output ) {return;}
+    header.nEvents = nEvents;
+    WriteHeader();
+    output->close();
+    delete output;
+    output = 0;
+    
+    G4cout << "\nPhase-space file: " << fileName << " " << header.nRecords << " particles from "
+           << header.nEvents << " events" << G4endl;
+}
+
+void PhaseSpaceWriter::Fill( G4int eventID, const G4Track* track )
+{
+    const G4ThreeVector& pos = track->GetPosition();
+    const G4ThreeVector& dir = track->GetMomentumDirection();
+    
+    PhaseSpaceRecord rec;
+    rec.eventID = eventID;
+    rec.pdgCode = track->GetDefinition()->GetPDGEncoding();
+    rec.x = static_cast<G4float>( pos.x()/mm );
+    rec.y = static_cast<G4float>( pos.y()/mm );
+    rec.z = static_cast<G4float>( pos.z()/mm );
+    rec.dx = static_cast<G4float>( dir.x() );
+    rec.dy = static_cast<G4float>( dir.y() );
+    rec.dz = static_cast<G4float>( dir.z() );
+    rec.kineticEnergy = static_cast<G4float>( track->GetKineticEnergy()/MeV );
+    rec.time = static_cast<G4float>( track->GetGlobalTime()/ns );
+    rec.weight = static_cast<G4float>( track->GetWeight() );
+    
+    output->write( reinterpret_cast<const char*>(&rec), sizeof(rec) );
+    ++header.nRecords;
+}
+
+G4bool PhaseSpaceWriter::MergeFiles( const std::vector<std::string>& inFiles, const std::string& outFile )
+{
+    // Records of one event are all in the same worker file, so the files are simply
+    // appended one after the other, the header totals are summed
+    if ( inFiles.empty() ) {return false;}
+    
+    std::ofstream out( outFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+    if ( !out.good() )
+    {
+        G4cerr << "Error opening the file: " << outFile << " worker phase-space files will not be merged." << G4endl;
+        return false;
+    }
+    
+    PhaseSpaceHeader total;
+    std::memset( &total, 0, sizeof(total) );
+    std::strncpy( total.magic, "PSTEPPS", sizeof(total.magic) );
+    total.version = 1;
+    total.recordSize = sizeof(PhaseSpaceRecord);
+    out.write( reinterpret_cast<const char*>(&total), sizeof(total) );
+    
+    std::vector<char> buffer( 1 << 20 );
+    for ( size_t i = 0 ; i < inFiles.size() ; ++i )
+    {
+        std::ifstream in( inFiles[i].c_str(), std::ios::in | std::ios::binary );
+        PhaseSpaceHeader h;
+        if ( !in.read( reinterpret_cast<char*>(&h), sizeof(h) ) || h.recordSize != total.recordSize )
+        {
+            G4cerr << "Error reading the phase-space file: " << inFiles[i] << ", skipped." << G4endl;
+            continue;
+        }
+        total.nEvents += h.nEvents;
+        total.nRecords += h.nRecords;
+        while ( in.read( &buffer[0], buffer.size() ) || in.gcount() > 0 )
+        {
+            out.write( &buffer[0], in.gcount() );
+        }
+        in.close();
+        std::remove( inFiles[i].c_str() );
+    }
+    
+    out.seekp( 0 , std::ios::beg );
+    out.write( reinterpret_cast<const char*>(&total), sizeof(total) );
+    out.close();
+    
+    G4cout << "\nMerged " << inFiles.size() << " worker phase-space files into: " << outFile
+           << " (" << total.nRecords << " particles from " << total.nEvents << " events)\n" << G4endl;
+    return true;
+}
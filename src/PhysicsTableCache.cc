@@ -0,0 +1,203 @@
+
+#include "PhysicsTableCache.hh"
+
+#include "G4VUserPhysicsList.hh"
+#include "G4StateManager.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4Isotope.hh"
+#include "G4IonisParamMat.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4ParticleTable.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
+#include "G4EmParameters.hh"
+#include "G4Version.hh"
+
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace
+{
+    // FNV-1a, 64 bit
+    unsigned long long HashString( const std::string& s )
+    {
+        unsigned long long h = 0xCBF29CE484222325ULL;
+        for ( size_t i = 0 ; i < s.size() ; ++i )
+        {
+            h ^= static_cast<unsigned char>( s[i] );
+            h *= 0x100000001B3ULL;
+        }
+        return h;
+    }
+
+    G4bool IsDirectory( const G4String& path )
+    {
+        struct stat info;
+        return stat( path.c_str(), &info ) == 0 && S_ISDIR( info.st_mode );
+    }
+
+    // Removes the files of a directory that was not renamed, then the directory
+    void RemoveDirectory( const G4String& path )
+    {
+        DIR* dir = opendir( path.c_str() );
+        if ( dir )
+        {
+            struct dirent* entry;
+            while ( ( entry = readdir( dir ) ) )
+            {
+                G4String name = entry->d_name;
+                if ( name != "." && name != ".." ) {std::remove( ( path + "/" + name ).c_str() );}
+            }
+            closedir( dir );
+        }
+        rmdir( path.c_str() );
+    }
+}
+
+PhysicsTableCache::PhysicsTableCache( const G4String& dir, G4VUserPhysicsList* list ) :
+    G4VStateDependent(),
+    cacheDir( dir ),
+    physicsList( list ),
+    storeDir( "" ),
+    retrieved( false )
+{
+    mkdir( cacheDir.c_str(), 0755 );
+    if ( !IsDirectory( cacheDir ) )
+    {
+        G4cerr << "PhysicsTableCache: cannot create " << cacheDir << ", physics tables are not cached" << G4endl;
+        cacheDir = "";
+    }
+    else {G4cout << "\nPhysics tables cached in " << cacheDir << "\n" << G4endl;}
+}
+
+PhysicsTableCache::~PhysicsTableCache()
+{
+}
+
+G4bool PhysicsTableCache::Notify( G4ApplicationState requestedState )
+{
+    if ( cacheDir == "" ) {return true;}
+    // The state has not been changed yet
+    const G4ApplicationState currentState = G4StateManager::GetStateManager()->GetCurrentState();
+
+    if ( currentState == G4State_Idle && requestedState == G4State_Init )
+    {
+        const G4String key = ComputeKey();
+        const G4String keyDir = cacheDir + "/" + key;
+        storeDir = "";
+        retrieved = IsDirectory( keyDir );
+        if ( retrieved )
+        {
+            physicsList->SetPhysicsTableRetrieved( keyDir );
+            G4cout << "PhysicsTableCache: retrieving the physics tables from " << keyDir << G4endl;
+        }
+        else
+        {
+            physicsList->ResetPhysicsTableRetrieved();
+            storeDir = keyDir;
+        }
+    }
+    else if ( currentState == G4State_Idle && requestedState == G4State_GeomClosed )
+    {
+        // The worker threads share the tables of the master, they must not read the files again
+        if ( retrieved ) {physicsList->ResetPhysicsTableRetrieved(); retrieved = false;}
+        if ( storeDir != "" )
+        {
+            std::ostringstream tmpDir;
+            tmpDir << storeDir << ".tmp" << getpid();
+            mkdir( tmpDir.str().c_str(), 0755 );
+            if ( physicsList->StorePhysicsTable( tmpDir.str() ) && rename( tmpDir.str().c_str(), storeDir.c_str() ) == 0 )
+            {
+                G4cout << "PhysicsTableCache: physics tables stored in " << storeDir << G4endl;
+            }
+            else
+            {
+                // Most likely stored by a concurrent job in the meantime
+                RemoveDirectory( tmpDir.str() );
+                if ( !IsDirectory( storeDir ) ) {G4cerr << "PhysicsTableCache: cannot store the physics tables in " << storeDir << G4endl;}
+            }
+            storeDir = "";
+        }
+    }
+    return true;
+}
+
+G4String PhysicsTableCache::ComputeKey() const
+{
+    std::ostringstream setup;
+    setup << std::setprecision(17) << G4VERSION_NUMBER << "\n";
+
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    for ( size_t i = 0 ; i < materials->size() ; ++i )
+    {
+        const G4Material* material = (*materials)[i];
+        setup << material->GetName() << " " << material->GetDensity() << " " << material->GetState() << " "
+              << material->GetTemperature() << " " << material->GetPressure() << " "
+              << material->GetIonisation()->GetMeanExcitationEnergy();
+        const G4double* fractions = material->GetFractionVector();
+        for ( size_t j = 0 ; j < material->GetNumberOfElements() ; ++j )
+        {
+            const G4Element* element = material->GetElement( j );
+            setup << " " << element->GetName() << " " << element->GetZ() << " " << fractions[j];
+            // Enriched 6Li converters differ from natural Li by the isotopes only
+            const G4double* abundances = element->GetRelativeAbundanceVector();
+            for ( size_t k = 0 ; k < element->GetNumberOfIsotopes() ; ++k )
+            {
+                setup << " " << element->GetIsotope( k )->GetN() << " " << abundances[k];
+            }
+        }
+        setup << "\n";
+    }
+
+    const G4RegionStore* regions = G4RegionStore::GetInstance();
+    const G4ProductionCuts* defaultCuts = G4ProductionCutsTable::GetProductionCutsTable()->GetDefaultProductionCuts();
+    for ( size_t i = 0 ; i < regions->size() ; ++i )
+    {
+        G4Region* region = (*regions)[i];
+        const G4ProductionCuts* cuts = region->GetProductionCuts() ? region->GetProductionCuts() : defaultCuts;
+        setup << region->GetName();
+        if ( cuts )
+        {
+            setup << " " << cuts->GetProductionCut("gamma") << " " << cuts->GetProductionCut("e-")
+                  << " " << cuts->GetProductionCut("e+") << " " << cuts->GetProductionCut("proton");
+        }
+        std::vector<G4Material*>::const_iterator itMaterial = region->GetMaterialIterator();
+        for ( size_t j = 0 ; j < region->GetNumberOfMaterials() ; ++j, ++itMaterial )
+        {
+            setup << " " << (*itMaterial)->GetName();
+        }
+        setup << "\n";
+    }
+    setup << G4ProductionCutsTable::GetProductionCutsTable()->GetLowEdgeEnergy() << " "
+          << G4ProductionCutsTable::GetProductionCutsTable()->GetHighEdgeEnergy() << "\n";
+
+#if G4VERSION_NUMBER >= 1050
+    G4EmParameters::Instance()->StreamInfo( setup );
+#endif
+
+    // The physics list is identified by the processes it attached to the particles
+    G4ParticleTable::G4PTblDicIterator* particles = G4ParticleTable::GetParticleTable()->GetIterator();
+    particles->reset();
+    while ( (*particles)() )
+    {
+        const G4ParticleDefinition* particle = particles->value();
+        G4ProcessManager* processManager = particle->GetProcessManager();
+        if ( !processManager ) continue;
+        const G4ProcessVector* processes = processManager->GetProcessList();
+        setup << particle->GetParticleName();
+        for ( size_t j = 0 ; j < processes->size() ; ++j ) {setup << " " << (*processes)[j]->GetProcessName();}
+        setup << "\n";
+    }
+
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << HashString( setup.str() );
+    return key.str();
+}
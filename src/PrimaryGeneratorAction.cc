@@ -1,30 +1,155 @@
 
 #include "PrimaryGeneratorAction.hh"
-#include "PrimaryGeneratorAction.hh"
+#include "PrimaryGeneratorMessenger.hh"
+#include "PhaseSpaceGenerator.hh"
+#include "FastSource.hh"
+#include "EventSeeder.hh"
 
 #include "G4Event.hh"
 #include "G4ParticleGun.hh"
 #include "G4GeneralParticleSource.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "Randomize.hh"
+#include "G4Exception.hh"
+
+#include <algorithm>
 
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
 
 PrimaryGeneratorAction::PrimaryGeneratorAction()
-  : outfile(0)
+  : phaseSpaceGun(0), fastSource(0), useFastSource(false), biasFraction(0.), biasCosAngle(std::cos(30.*deg)), biasAxis(0.,0.,1.), useEnergySpectrum(false), outfile(0)
 {
   gun = InitializeGPS();
-  
+  fastSource = new FastSource();
+  messenger = new PrimaryGeneratorMessenger(this);
 }
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 { 
-  gun->GeneratePrimaryVertex(anEvent);
+  // Every event starts from its own seeds, independent of the thread and of the previous events
+  EventSeeder::SeedEvent(anEvent);
+  
+  if ( phaseSpaceGun ) {phaseSpaceGun->GeneratePrimaryVertex(anEvent); return;}
+  
+  G4int firstVertex = anEvent->GetNumberOfPrimaryVertex();
+  if ( useFastSource ) fastSource->GeneratePrimaryVertex(anEvent);
+  else gun->GeneratePrimaryVertex(anEvent);
+  if ( biasFraction > 0. ) BiasDirections(anEvent, firstVertex);
+  
+  // O(1) energy from the alias table, replaces the GPS energy (use /gps/ene/type Mono
+  // so that the GPS does not sample an Arb spectrum for nothing)
+  if ( useEnergySpectrum )
+  {
+    for ( G4int i = firstVertex ; i < anEvent->GetNumberOfPrimaryVertex() ; ++i )
+    {
+      for ( G4PrimaryParticle* primary = anEvent->GetPrimaryVertex(i)->GetPrimary() ; primary ; primary = primary->GetNext() )
+      {
+        primary->SetKineticEnergy( energySpectrum.Sample() );
+      }
+    }
+  }
+}
+
+void PrimaryGeneratorAction::SetEnergySpectrumFile(const G4String& fileName)
+{
+  if ( fileName == "none" || fileName.empty() ) {useEnergySpectrum = false; return;}
+  useEnergySpectrum = energySpectrum.LoadFile(fileName);
+}
+
+void PrimaryGeneratorAction::PrepareEnergySpectrum()
+{
+  if ( !useEnergySpectrum ) return;
+  if ( !energySpectrum.BuildTable() )
+  {
+    G4cerr << "Energy spectrum can not be sampled, the source energy is used" << G4endl;
+    useEnergySpectrum = false;
+  }
+}
+
+void PrimaryGeneratorAction::SetDirectionBiasAxis(const G4ThreeVector& axis)
+{
+  if ( axis.mag2() == 0. )
+  {
+    G4ExceptionDescription msg;
+    msg << "The axis of the direction bias cone can not be zero, keeping " << biasAxis;
+    G4Exception("PrimaryGeneratorAction::SetDirectionBiasAxis()", "pstepGun001", JustWarning, msg);
+    return;
+  }
+  biasAxis = axis.unit();
+}
+
+void PrimaryGeneratorAction::CheckDirectionBias()
+{
+  // The phase-space replay is never biased
+  if ( biasFraction <= 0. || phaseSpaceGun ) return;
+  
+  // The weights are only meaningful with respect to an isotropic source (checked for the current GPS source)
+  G4bool isotropic = useFastSource ? fastSource->GetAngularType() == FastSource::iso
+                                   : gps->GetCurrentSource()->GetAngDist()->GetDistType() == "iso";
+  if ( !isotropic )
+  {
+    G4ExceptionDescription msg;
+    msg << "/det/gun/directionBias needs an isotropic source (/gps/ang/type iso or /det/gun/fast/angle iso),"
+        << " set the fraction to 0 or change the angular distribution";
+    G4Exception("PrimaryGeneratorAction::CheckDirectionBias()", "pstepGun002", FatalErrorInArgument, msg);
+  }
+}
+
+void PrimaryGeneratorAction::BiasDirections(G4Event* anEvent, G4int firstVertex)
+{
+  // The source direction (isotropic, /gps/ang/type iso or /det/gun/fast/angle iso, see CheckDirectionBias) is replaced by one drawn from
+  //   q = (1-f)/4pi + f/Omega_cone inside the cone,
+  // the isotropic part keeps every direction possible so that the weight 1/(4pi q) is bounded
+  // and the weighted result is the one of the isotropic source.
+  const G4double coneSolidAngle = twopi*(1.-biasCosAngle);
+  for ( G4int i = firstVertex ; i < anEvent->GetNumberOfPrimaryVertex() ; ++i )
+  {
+    G4double cosTheta = ( G4UniformRand() < biasFraction ) ? 1.-G4UniformRand()*(1.-biasCosAngle)
+                                                           : 2.*G4UniformRand()-1.;
+    G4double sinTheta = std::sqrt(std::max(0.,1.-cosTheta*cosTheta));
+    G4double phi = twopi*G4UniformRand();
+    G4ThreeVector direction(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+    direction.rotateUz(biasAxis);
+    
+    G4double pdf = (1.-biasFraction)/(4.*pi);
+    if ( cosTheta >= biasCosAngle ) pdf += biasFraction/coneSolidAngle;
+    
+    // GPS gives all the particles of a vertex the same direction
+    G4PrimaryVertex* vertex = anEvent->GetPrimaryVertex(i);
+    for ( G4PrimaryParticle* primary = vertex->GetPrimary() ; primary ; primary = primary->GetNext() )
+    {
+      primary->SetMomentumDirection(direction);
+    }
+    vertex->SetWeight( vertex->GetWeight()/(4.*pi*pdf) );
+  }
+}
+
+void PrimaryGeneratorAction::SetPhaseSpaceFile(const G4String& fileName)
+{
+  if ( fileName == "none" || fileName.empty() )
+  {
+    delete phaseSpaceGun;
+    phaseSpaceGun = 0;
+    return;
+  }
+  if ( !phaseSpaceGun ) phaseSpaceGun = new PhaseSpaceGenerator();
+  if ( !phaseSpaceGun->SetFileName(fileName) )
+  {
+    // keep the GPS if the file can not be read
+    delete phaseSpaceGun;
+    phaseSpaceGun = 0;
+  }
 }
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
 {
+  delete messenger;
+  delete phaseSpaceGun;
+  delete fastSource;
   delete gun;
 }
 
@@ -0,0 +1,168 @@
+
+#include "PrimaryGeneratorMessenger.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWith3Vector.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "FastSource.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+PrimaryGeneratorMessenger::PrimaryGeneratorMessenger(PrimaryGeneratorAction* primaryGeneratorAction) :
+	action(primaryGeneratorAction)
+{
+	gunDir = new G4UIdirectory("/det/gun/");
+	gunDir->SetGuidance("primary generator selection and source biasing");
+
+	replayPhaseSpaceCmd = new G4UIcmdWithAString("/det/gun/replayPhaseSpace",this);
+	replayPhaseSpaceCmd->SetGuidance("Generate the events from a phase-space file written with /det/phaseSpace/record");
+	replayPhaseSpaceCmd->SetGuidance("instead of the GPS source (none to go back to the GPS).");
+	replayPhaseSpaceCmd->SetParameterName("fileName",false);
+	replayPhaseSpaceCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	directionBiasCmd = new G4UIcmdWithADouble("/det/gun/directionBias",this);
+	directionBiasCmd->SetGuidance("Fraction of the primaries of an isotropic source (/gps/ang/type iso or /det/gun/fast/angle iso) emitted into the bias cone");
+	directionBiasCmd->SetGuidance("(0 switches the biasing off). The weight is stored as event_weight in the trees.");
+	directionBiasCmd->SetParameterName("fraction",false);
+	directionBiasCmd->SetRange("fraction>=0 && fraction<1");
+	directionBiasCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	directionBiasAngleCmd = new G4UIcmdWithADoubleAndUnit("/det/gun/directionBiasAngle",this);
+	directionBiasAngleCmd->SetGuidance("Half opening angle of the bias cone, it should contain the shield/converter/sensor stack");
+	directionBiasAngleCmd->SetParameterName("angle",false);
+	directionBiasAngleCmd->SetRange("angle>0 && angle<=180");
+	directionBiasAngleCmd->SetUnitCategory("Angle");
+	directionBiasAngleCmd->SetDefaultUnit("deg");
+	directionBiasAngleCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	directionBiasAxisCmd = new G4UIcmdWith3Vector("/det/gun/directionBiasAxis",this);
+	directionBiasAxisCmd->SetGuidance("Axis of the bias cone, non-zero (default 0 0 1, towards the detector stack)");
+	directionBiasAxisCmd->SetParameterName("x","y","z",false);
+	directionBiasAxisCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	energySpectrumCmd = new G4UIcmdWithAString("/det/gun/energySpectrum",this);
+	energySpectrumCmd->SetGuidance("Sample the primary energy from a spectrum file (lines: energy in MeV, intensity)");
+	energySpectrumCmd->SetGuidance("with an alias table instead of the GPS energy distribution, none to use the GPS again.");
+	energySpectrumCmd->SetParameterName("fileName",false);
+	energySpectrumCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	energySpectrumInterCmd = new G4UIcmdWithAString("/det/gun/energySpectrumInter",this);
+	energySpectrumInterCmd->SetGuidance("Interpolation between the spectrum points (as /gps/hist/inter)");
+	energySpectrumInterCmd->SetParameterName("inter",false);
+	energySpectrumInterCmd->SetCandidates("Lin Spline");
+	energySpectrumInterCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	energySpectrumBinsCmd = new G4UIcmdWithAnInteger("/det/gun/energySpectrumBins",this);
+	energySpectrumBinsCmd->SetGuidance("Number of equal width bins of the alias table (default 10000)");
+	energySpectrumBinsCmd->SetParameterName("bins",false);
+	energySpectrumBinsCmd->SetRange("bins>0");
+	energySpectrumBinsCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	modeCmd = new G4UIcmdWithAString("/det/gun/mode",this);
+	modeCmd->SetGuidance("Primary generator: gps (G4GeneralParticleSource, /gps/ commands) or fast");
+	modeCmd->SetGuidance("(G4ParticleGun, /gun/particle, /gun/energy and /det/gun/fast/ commands).");
+	modeCmd->SetParameterName("mode",false);
+	modeCmd->SetCandidates("gps fast");
+	modeCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	fastDir = new G4UIdirectory("/det/gun/fast/");
+	fastDir->SetGuidance("position and direction of the fast (G4ParticleGun) source");
+
+	fastCentreCmd = new G4UIcmdWith3VectorAndUnit("/det/gun/fast/centre",this);
+	fastCentreCmd->SetGuidance("Centre of the point/disk source");
+	fastCentreCmd->SetParameterName("x","y","z",false);
+	fastCentreCmd->SetDefaultUnit("mm");
+	fastCentreCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	fastAxisCmd = new G4UIcmdWith3Vector("/det/gun/fast/axis",this);
+	fastAxisCmd->SetGuidance("Beam axis (beam2d and fixed directions) and disk normal, default 0 0 1");
+	fastAxisCmd->SetParameterName("x","y","z",false);
+	fastAxisCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	fastDiskRadiusCmd = new G4UIcmdWithADoubleAndUnit("/det/gun/fast/diskRadius",this);
+	fastDiskRadiusCmd->SetGuidance("Radius of a uniform disk source, 0 for a point source");
+	fastDiskRadiusCmd->SetParameterName("radius",false);
+	fastDiskRadiusCmd->SetRange("radius>=0");
+	fastDiskRadiusCmd->SetUnitCategory("Length");
+	fastDiskRadiusCmd->SetDefaultUnit("mm");
+	fastDiskRadiusCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	fastAngleCmd = new G4UIcmdWithAString("/det/gun/fast/angle",this);
+	fastAngleCmd->SetGuidance("Angular distribution: iso, beam2d (gaussian around the axis) or fixed (along the axis)");
+	fastAngleCmd->SetParameterName("type",false);
+	fastAngleCmd->SetCandidates("iso beam2d fixed");
+	fastAngleCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	fastBeamSigmaXCmd = new G4UIcmdWithADoubleAndUnit("/det/gun/fast/beamSigmaX",this);
+	fastBeamSigmaXCmd->SetGuidance("Angular spread in x of the beam2d distribution");
+	fastBeamSigmaXCmd->SetParameterName("sigmaX",false);
+	fastBeamSigmaXCmd->SetUnitCategory("Angle");
+	fastBeamSigmaXCmd->SetDefaultUnit("mrad");
+	fastBeamSigmaXCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	fastBeamSigmaYCmd = new G4UIcmdWithADoubleAndUnit("/det/gun/fast/beamSigmaY",this);
+	fastBeamSigmaYCmd->SetGuidance("Angular spread in y of the beam2d distribution");
+	fastBeamSigmaYCmd->SetParameterName("sigmaY",false);
+	fastBeamSigmaYCmd->SetUnitCategory("Angle");
+	fastBeamSigmaYCmd->SetDefaultUnit("mrad");
+	fastBeamSigmaYCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+}
+
+
+PrimaryGeneratorMessenger::~PrimaryGeneratorMessenger()
+{
+	delete replayPhaseSpaceCmd;
+	delete directionBiasCmd;
+	delete directionBiasAngleCmd;
+	delete directionBiasAxisCmd;
+	delete energySpectrumCmd;
+	delete energySpectrumInterCmd;
+	delete energySpectrumBinsCmd;
+	delete modeCmd;
+	delete fastCentreCmd;
+	delete fastAxisCmd;
+	delete fastDiskRadiusCmd;
+	delete fastAngleCmd;
+	delete fastBeamSigmaXCmd;
+	delete fastBeamSigmaYCmd;
+	delete fastDir;
+	delete gunDir;
+}
+
+void PrimaryGeneratorMessenger::SetNewValue(G4UIcommand* cmd,G4String newValue)
+{
+	if ( cmd == replayPhaseSpaceCmd )
+		action->SetPhaseSpaceFile( newValue );
+	if ( cmd == directionBiasCmd )
+		action->SetDirectionBiasFraction( directionBiasCmd->GetNewDoubleValue(newValue) );
+	if ( cmd == directionBiasAngleCmd )
+		action->SetDirectionBiasAngle( directionBiasAngleCmd->GetNewDoubleValue(newValue) );
+	if ( cmd == directionBiasAxisCmd )
+		action->SetDirectionBiasAxis( directionBiasAxisCmd->GetNew3VectorValue(newValue) );
+	if ( cmd == energySpectrumCmd )
+		action->SetEnergySpectrumFile( newValue );
+	if ( cmd == energySpectrumInterCmd )
+		action->GetEnergySpectrum()->SetSpline( newValue == "Spline" );
+	if ( cmd == energySpectrumBinsCmd )
+		action->GetEnergySpectrum()->SetNumberOfBins( energySpectrumBinsCmd->GetNewIntValue(newValue) );
+	if ( cmd == modeCmd )
+		action->SetFastSource( newValue == "fast" );
+	if ( cmd == fastCentreCmd )
+		action->GetFastSource()->SetCentre( fastCentreCmd->GetNew3VectorValue(newValue) );
+	if ( cmd == fastAxisCmd )
+		action->GetFastSource()->SetAxis( fastAxisCmd->GetNew3VectorValue(newValue) );
+	if ( cmd == fastDiskRadiusCmd )
+		action->GetFastSource()->SetDiskRadius( fastDiskRadiusCmd->GetNewDoubleValue(newValue) );
+	if ( cmd == fastAngleCmd )
+	{
+		if ( newValue == "iso" ) action->GetFastSource()->SetAngularType( FastSource::iso );
+		else if ( newValue == "beam2d" ) action->GetFastSource()->SetAngularType( FastSource::beam2d );
+		else action->GetFastSource()->SetAngularType( FastSource::fixed );
+	}
+	if ( cmd == fastBeamSigmaXCmd )
+		action->GetFastSource()->SetBeamSigmaX( fastBeamSigmaXCmd->GetNewDoubleValue(newValue) );
+	if ( cmd == fastBeamSigmaYCmd )
+		action->GetFastSource()->SetBeamSigmaY( fastBeamSigmaYCmd->GetNewDoubleValue(newValue) );
+}
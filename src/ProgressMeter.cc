@@ -0,0 +1,118 @@
+
+#include "ProgressMeter.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+G4double ProgressMeter::interval = 10.;
+G4int ProgressMeter::nEventsToProcess = 0;
+std::atomic<G4int> ProgressMeter::nEventsDone(0);
+std::atomic<G4int> ProgressMeter::nEventsWithHits(0);
+G4double ProgressMeter::startTime = 0.;
+std::atomic<G4double> ProgressMeter::lastPrintTime(0.);
+
+namespace
+{
+    G4Mutex progressMutex = G4MUTEX_INITIALIZER;
+    
+    // The clock is read once every kClockEvents events (of all the threads together)
+    const G4int kClockEvents = 16;
+    
+    // Wall clock in seconds
+    inline G4double WallTime()
+    {
+        return std::chrono::duration<G4double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+}
+
+ProgressMeter::ProgressMeter()
+{
+    progressDir = new G4UIdirectory("/det/progress/");
+    progressDir->SetGuidance("progress report of the run");
+    
+    intervalCmd = new G4UIcmdWithADoubleAndUnit("/det/progress/interval",this);
+    intervalCmd->SetGuidance("Minimum time between two progress lines (events done, events/s, ETA, events with hits).");
+    intervalCmd->SetGuidance("0 switches the report off.");
+    intervalCmd->SetParameterName("interval",false);
+    intervalCmd->SetRange("interval>=0");
+    intervalCmd->SetUnitCategory("Time");
+    intervalCmd->SetDefaultUnit("s");
+    intervalCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+    // The setting is shared by all the threads, set it once on the master
+    intervalCmd->SetToBeBroadcasted(false);
+}
+
+ProgressMeter::~ProgressMeter()
+{
+    delete intervalCmd;
+    delete progressDir;
+}
+
+void ProgressMeter::SetNewValue( G4UIcommand* cmd, G4String newValue )
+{
+    if ( cmd == intervalCmd ) {interval = intervalCmd->GetNewDoubleValue(newValue)/s;}
+}
+
+void ProgressMeter::BeginOfRun( G4int nEvents )
+{
+    G4AutoLock lock(&progressMutex);
+    nEventsToProcess = nEvents;
+    nEventsDone = 0;
+    nEventsWithHits = 0;
+    startTime = WallTime();
+    lastPrintTime = startTime;
+}
+
+void ProgressMeter::EventDone( G4bool hasHits )
+{
+    if ( hasHits ) {++nEventsWithHits;}
+    G4int done = ++nEventsDone;
+    if ( interval <= 0. || done % kClockEvents != 0 ) return;
+    
+    G4double now = WallTime();
+    if ( now - lastPrintTime < interval ) return;
+    
+    // A line is due: one thread prints it, the others find lastPrintTime updated
+    G4AutoLock lock(&progressMutex);
+    if ( now - lastPrintTime < interval ) return;
+    lastPrintTime = now;
+    Print( now );
+}
+
+void ProgressMeter::EndOfRun()
+{
+    G4AutoLock lock(&progressMutex);
+    if ( interval <= 0. || nEventsDone == 0 ) return;
+    Print( WallTime() );
+}
+
+void ProgressMeter::Print( G4double now )
+{
+    // Snapshot of the counters, the other threads keep counting while the line is printed
+    const G4int nEventsDone = ProgressMeter::nEventsDone;
+    const G4int nEventsWithHits = ProgressMeter::nEventsWithHits;
+    G4double elapsed = now - startTime;
+    G4double rate = elapsed > 0. ? nEventsDone/elapsed : 0.;
+    
+    G4cout << "Events: " << nEventsDone << " / " << nEventsToProcess
+           << std::fixed << std::setprecision(1)
+           << " (" << 100.*nEventsDone/std::max(nEventsToProcess,1) << "%), "
+           << rate << " events/s, ";
+    if ( rate > 0. && nEventsDone < nEventsToProcess )
+    {
+        G4cout << "ETA " << (nEventsToProcess-nEventsDone)/rate << " s, ";
+    }
+    else
+    {
+        G4cout << "elapsed " << elapsed << " s, ";
+    }
+    G4cout << "with hits: " << std::setprecision(3) << 100.*nEventsWithHits/nEventsDone << "%" << G4endl;
+    G4cout.unsetf( std::ios::floatfield );
+    G4cout << std::setprecision(6);
+}
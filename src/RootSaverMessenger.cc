@@ -0,0 +1,65 @@
+
+#include "RootSaverMessenger.hh"
+#include "RootSaver.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithABool.hh"
+
+RootSaverMessenger::RootSaverMessenger(RootSaver* rootSaver) :
+	saver(rootSaver)
+{
+	outputDir = new G4UIdirectory("/det/output/");
+	outputDir->SetGuidance("commands related to the ROOT output file (applied at the next /run/beamOn)");
+
+	sparseSignalCmd = new G4UIcmdWithABool("/det/output/sparseSignal",this);
+	sparseSignalCmd->SetGuidance("Store the signal of each plane as (channel, charge) vectors of the channels");
+	sparseSignalCmd->SetGuidance("above threshold, instead of one dense array entry per strip/pixel.");
+	sparseSignalCmd->SetParameterName("sparseSignal",true);
+	sparseSignalCmd->SetDefaultValue(true);
+	sparseSignalCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	signalThresholdCmd = new G4UIcmdWithADouble("/det/output/signalThreshold",this);
+	signalThresholdCmd->SetGuidance("Minimum charge (in elementary charge units) for a channel to be stored in sparse mode.");
+	signalThresholdCmd->SetParameterName("signalThreshold",true);
+	signalThresholdCmd->SetDefaultValue(0);
+	signalThresholdCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	skipEmptyEventsCmd = new G4UIcmdWithABool("/det/output/skipEmptyEvents",this);
+	skipEmptyEventsCmd->SetGuidance("Only write the events with hits in the detector planes (and, see eventChargeThreshold,");
+	skipEmptyEventsCmd->SetGuidance("with enough charge). The number of generated events is kept in the run_info tree.");
+	skipEmptyEventsCmd->SetParameterName("skipEmptyEvents",true);
+	skipEmptyEventsCmd->SetDefaultValue(true);
+	skipEmptyEventsCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+
+	eventChargeThresholdCmd = new G4UIcmdWithADouble("/det/output/eventChargeThreshold",this);
+	eventChargeThresholdCmd->SetGuidance("With skipEmptyEvents, minimum charge (in elementary charge units) of the largest");
+	eventChargeThresholdCmd->SetGuidance("strip/pixel signal for an event to be written (0: any event with hits).");
+	eventChargeThresholdCmd->SetParameterName("eventChargeThreshold",true);
+	eventChargeThresholdCmd->SetDefaultValue(0);
+	eventChargeThresholdCmd->AvailableForStates(G4State_PreInit,G4State_Idle);
+}
+
+
+RootSaverMessenger::~RootSaverMessenger()
+{
+	delete sparseSignalCmd;
+	delete signalThresholdCmd;
+	delete skipEmptyEventsCmd;
+	delete eventChargeThresholdCmd;
+	delete outputDir;
+}
+
+void RootSaverMessenger::SetNewValue(G4UIcommand* cmd,G4String newValue)
+{
+	if ( cmd == sparseSignalCmd )
+		saver->SetSparseSignal( sparseSignalCmd->GetNewBoolValue(newValue) );
+
+	if ( cmd == signalThresholdCmd )
+		saver->SetSignalThreshold( signalThresholdCmd->GetNewDoubleValue(newValue) );
+
+	if ( cmd == skipEmptyEventsCmd )
+		saver->SetSkipEmptyEvents( skipEmptyEventsCmd->GetNewBoolValue(newValue) );
+
+	if ( cmd == eventChargeThresholdCmd )
+		saver->SetEventChargeThreshold( eventChargeThresholdCmd->GetNewDoubleValue(newValue) );
+}
@@ -4,46 +4,91 @@
 #include "PrimaryGeneratorAction.hh"
 #include "G4Run.hh"
 #include "DetectorConstruction.hh"
+#include "ProgressMeter.hh"
 
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
 
 #include "G4GeneralParticleSource.hh"
+#include "G4Threading.hh"
+#include "G4AutoLock.hh"
 
 #include <string>
 
+time_t RunAction::runUID = 0;
+std::vector<std::string> RunAction::workerFiles_strip;
+std::vector<std::string> RunAction::workerFiles_pixel;
+std::vector<std::string> RunAction::workerFiles_phsp;
+
+namespace { G4Mutex workerFilesMutex = G4MUTEX_INITIALIZER; }
+
 RunAction::RunAction(  /*G4VUser*/PrimaryGeneratorAction * thePGAction, EventAction* theEventAction, DetectorConstruction* myDC ) :
-	primGenAction(thePGAction), eventAction(theEventAction), myDetector(myDC)
+	progress(0), primGenAction(thePGAction), eventAction(theEventAction), myDetector(myDC)
+{
+	if ( !G4Threading::IsWorkerThread() ) {progress = new ProgressMeter();}
+	// The master thread of a multithreaded run has no EventAction
+	// and does not write any event data
+	if ( eventAction ) {eventAction->SetRootSaver( &saver );}
+}
+
+RunAction::~RunAction()
 {
-	eventAction->SetRootSaver( &saver );
+	delete progress;
 }
 
 void RunAction::BeginOfRunAction(const G4Run* aRun )
 {
     
 	G4cout << "Starting Run: " << aRun->GetRunID() << G4endl;
+	if ( progress ) {ProgressMeter::BeginOfRun( aRun->GetNumberOfEventToBeProcessed() );}
+    
+    // unique ID for filename based on system clock, combined with depth info and run no. also
+    // written to filename should prevents any overwrites when running in batch mode.
+    // The master starts the run before the workers, which then reuse its ID
+    if ( !G4Threading::IsWorkerThread() ) {runUID = time(NULL);}
+    
+	if ( !eventAction )
+    {
+        // Master of a MT run: the workers will report the files they write
+        G4AutoLock lock(&workerFilesMutex);
+        workerFiles_strip.clear();
+        workerFiles_pixel.clear();
+        workerFiles_phsp.clear();
+        return;
+    }
+	// Alias table of the energy spectrum, built once per run and thread
+	if ( primGenAction ) {primGenAction->PrepareEnergySpectrum();}
+	if ( primGenAction ) {primGenAction->CheckDirectionBias();}
+    
 	// For each run a new TTree is created, with default names
     
+    // In MT mode each worker thread writes its own file, tagged with the thread ID
+    std::ostringstream thread_tag;
+    if ( G4Threading::IsWorkerThread() ) {thread_tag << "_t" << G4Threading::G4GetThreadId();}
+    
     // Info on tracker geom now written once per run in the EndOfRunAction() function below
     if( myDetector->Get_build_strip_detectors() )
     {
         std::ostringstream fn;
         float z_pos = myDetector->Get_zShift_pixel_tracker();
-        fn << "strip_tree" << "_" << z_pos << "mm_depth" ;
-        saver.CreateTree_strip_det(fn.str(),"trackerData_strip", myDetector->Get_nb_of_strips());
+        fn << "strip_tree" << "_" << z_pos << "mm_depth" << thread_tag.str();
+        saver.CreateTree_strip_det(fn.str(),"trackerData_strip", myDetector->Get_nb_of_strips(), myDetector->Get_nb_of_planes());
     }
     
-    // unique ID for filename based on system clock, combined with depth info and run no. also
-    // written to filename should prevents any overwrites when running in batch mode
-    time_t systime = time(NULL);
-    
     // Info on tracker geom now written once per run in the EndOfRunAction() function below
     if( myDetector->Get_build_pixel_detectors() )
     {
         std::ostringstream fn;
         float z_pos = myDetector->Get_zShift_pixel_tracker();
-        fn << "pixel_tree_" << z_pos << "mm_depth_uid_" << systime;
-        saver.CreateTree_pixel_det(fn.str(),"trackerData_pixel", myDetector->Get_nb_of_pixels());
+        fn << "pixel_tree_" << z_pos << "mm_depth_uid_" << runUID << thread_tag.str();
+        saver.CreateTree_pixel_det(fn.str(),"trackerData_pixel", myDetector->Get_nb_of_pixels(), myDetector->Get_nb_of_pix_planes());
+    }
+    
+    if( phaseSpace.IsEnabled() )
+    {
+        std::ostringstream fn;
+        fn << phaseSpace.GetFileBaseName() << "_run" << aRun->GetRunID() << thread_tag.str() << ".phsp";
+        phaseSpace.Open(fn.str());
     }
     
     //Print detector rotations to terminal
@@ -59,7 +104,41 @@ void RunAction::BeginOfRunAction(const G4Run* aRun )
 
 void RunAction::EndOfRunAction( const G4Run* aRun )
 {
-    if( myDetector->Get_build_strip_detectors() )
+    if( !eventAction )
+    {
+        // Master of a MT run: all workers have closed their files at this point,
+        // merge them into one file per tree with the same name a sequential run would give
+        G4AutoLock lock(&workerFilesMutex);
+        float z_pos = myDetector->Get_zShift_pixel_tracker();
+        
+        if( myDetector->Get_build_strip_detectors() )
+        {
+            std::ostringstream fn;
+            fn << "strip_tree" << "_" << z_pos << "mm_depth" << "_run" << aRun->GetRunID() << ".root";
+            RootSaver::MergeFiles(workerFiles_strip, fn.str());
+        }
+        
+        if( myDetector->Get_build_pixel_detectors() )
+        {
+            std::ostringstream fn;
+            fn << "pixel_tree_" << z_pos << "mm_depth_uid_" << runUID << "_run" << aRun->GetRunID() << ".root";
+            RootSaver::MergeFiles(workerFiles_pixel, fn.str());
+        }
+        
+        if( phaseSpace.IsEnabled() )
+        {
+            std::ostringstream fn;
+            fn << phaseSpace.GetFileBaseName() << "_run" << aRun->GetRunID() << ".phsp";
+            PhaseSpaceWriter::MergeFiles(workerFiles_phsp, fn.str());
+        }
+        
+        if ( progress ) {ProgressMeter::EndOfRun();}
+        G4cout << "Ending Run: " << aRun->GetRunID() << G4endl;
+        return;
+    }
+    
+    // The geometry tree is identical for all threads, in MT mode only the first worker writes it
+    if( myDetector->Get_build_strip_detectors() && G4Threading::G4GetThreadId() <= 0 )
     {
         // Geometry info saved to file for tracking could be done by creating a TrackerGeometry/DetectorConstruction
         // object and saving to root tree, however this requires extra libraries dict.h/dict.cxx and linkdef.h to be
@@ -233,6 +312,19 @@ void RunAction::EndOfRunAction( const G4Run* aRun )
     // and geometry variables defined above
     
     saver.CloseTrees();
+    
+    G4bool phaseSpaceWritten = phaseSpace.IsOpen();
+    phaseSpace.Close( aRun->GetNumberOfEvent() );
+    
+    if( G4Threading::IsWorkerThread() )
+    {
+        G4AutoLock lock(&workerFilesMutex);
+        if( myDetector->Get_build_strip_detectors() ) {workerFiles_strip.push_back( saver.Get_file_name_strip() );}
+        if( myDetector->Get_build_pixel_detectors() ) {workerFiles_pixel.push_back( saver.Get_file_name_pixel() );}
+        if( phaseSpaceWritten ) {workerFiles_phsp.push_back( phaseSpace.GetFileName() );}
+    }
+    
+    if ( progress ) {ProgressMeter::EndOfRun();}
     G4cout << "Ending Run: " << aRun->GetRunID() << G4endl;
     // TTree are closed, with default names      
 }
@@ -47,8 +47,8 @@ G4bool SensitiveDetector_pix::ProcessHits(G4Step *step, G4TouchableHistory *)//*
 {
  
 
-  T01TrackInformation* info = new T01TrackInformation(step->GetTrack()); // you could write atrack its fine
-  //  T01TrackInformation* info = (T01TrackInformation*)(step->GetTrack()->GetUserInformation());
+  // Filled once per track by TrackingAction::PreUserTrackingAction (no allocation per step)
+  const T01TrackInformation* info = static_cast<const T01TrackInformation*>(step->GetTrack()->GetUserInformation());
   // G4cout << " OriginalTrackID " << info->GetOriginalTrackID() << G4endl;   // Now the code its crash, but if you cooment out this command it will work {{DONT CHANGE ITS WORK}} 
 
   //  G4cout << " Original Position " << info->GetOriginalPosition() << G4endl;
@@ -68,8 +68,9 @@ G4bool SensitiveDetector_pix::ProcessHits(G4Step *step, G4TouchableHistory *)//*
       
   //  info->Print();
   // G4cout <<  originalPosition = aTrackInfo->originalPosition << G4endl;
-  G4double truth_KE = info->GetkineticEnergy(); //********************************************** it may cause error
-  G4ThreeVector point = info->GetOriginalPosition(); //**********************************************************  originalPosition = aTrack->GetPosition(); from the track information class
+  // Origin vertex and initial K.E. of the track, straight from the track if no TrackingAction is registered
+  G4double truth_KE = info ? info->GetVertexKineticEnergy() : step->GetTrack()->GetVertexKineticEnergy();
+  G4ThreeVector point = info ? info->GetVertexPosition() : step->GetTrack()->GetVertexPosition();
   //G4cout point;
   //G4cout truth_KE; 
   //G4cout << "Position " << point  << " K.E "  << truth_KE << G4endl;
@@ -112,7 +113,7 @@ G4bool SensitiveDetector_pix::ProcessHits(G4Step *step, G4TouchableHistory *)//*
   //***********************************************************************************************
   G4ThreeVector momentum = step->GetPreStepPoint()->GetMomentum();
   // G4cout << "SensitiveDetector_pix momentum = " << momentum << G4endl;
- G4String Process_Name = step->GetPostStepPoint()->GetProcessDefinedStep()->GetProcessName();                                                 // I include this
+  const G4String& Process_Name = step->GetPostStepPoint()->GetProcessDefinedStep()->GetProcessName();                                                 // I include this
  //  G4cout << "ProcessName = " << Process_Name   << G4endl; // This will give you the process name on the current step
 
 
@@ -137,10 +138,27 @@ G4bool SensitiveDetector_pix::ProcessHits(G4Step *step, G4TouchableHistory *)//*
   G4int track = step->GetTrack()->GetTrackID();
   //G4int Z = step->GetTrack()->GetDefinition()->GetPDGCharge();
   
+  // One hit per (track, pixel): with the fine step limit in the sensor a single track makes
+  // hundreds of steps in the same pixel, so further steps are accumulated in the existing hit.
+  // Position is the energy weighted mean of the step positions, the process is the latest one.
+  std::pair<G4int,G4int> key(track,pixelCopyNo);
+  std::map< std::pair<G4int,G4int>, SiHit_pix* >::iterator found = hitMap.find(key);
+  if ( found != hitMap.end() )
+  {
+    SiHit_pix* hit = found->second;
+    G4double eSum = hit->GetEdep() + edep;
+    if ( eSum > 0. ) {hit->SetPosition( (hit->GetPosition()*hit->GetEdep() + pointE*edep)/eSum );}
+    hit->AddEdep(edep);
+    hit->AddNonIonisingEdep(ni_edep);
+    hit->SetProcessName(Process_Name);
+    return true;
+  }
+  
   SiHit_pix* hit = new SiHit_pix(pixelCopyNo,planeCopyNo,isPrimary,track);
   hitCollection->insert(hit);
+  hitMap[key] = hit;
 
-  G4String particleName = step->GetTrack()->GetDefinition()->GetParticleName();
+  const G4String& particleName = step->GetTrack()->GetDefinition()->GetParticleName();
   // G4String particleParent = step->GetTrack()->GetDefinition()->GetParticleName();                                                 // I include this
 
   // G4cout << "particleName = " << particleName   << G4endl;
@@ -179,6 +197,9 @@ G4bool SensitiveDetector_pix::ProcessHits(G4Step *step, G4TouchableHistory *)//*
   // store hit time
   hit->SetHitTime(htime);
 
+  // store track weight, different from 1 when importance biasing splits/roulettes the track
+  hit->SetWeight(step->GetTrack()->GetWeight());
+
   // hit->SetOriginalTrackID          //********************************************************************************************
 				
   // store position of energy deposition
@@ -211,6 +232,7 @@ void SensitiveDetector_pix::Initialize(G4HCofThisEvent* HCE)
   // -- collectionName[0] is "SiHit_pixCollection", as declared in constructor
   //hitCollection = new SiHit_pixCollection(GetName(), collectionName[0]);
   hitCollection = new SiHit_pixCollection(SensitiveDetectorName, collectionName[0]);
+  hitMap.clear();
 
     //G4cout << "HitCollection generated for pixel sensitive detector: " << SensitiveDetectorName;
     //G4cout << " and collectionName[0] = " << collectionName[0] << G4endl;
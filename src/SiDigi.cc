@@ -5,7 +5,7 @@
 #include "G4SystemOfUnits.hh"
 
 // -- one more nasty trick for new and delete operator overloading:
-G4Allocator<SiDigi> SiDigiAllocator;
+G4ThreadLocal G4Allocator<SiDigi>* SiDigiAllocator = 0;
 
 SiDigi::SiDigi(const int& pn, const int& sn) :
 		charge(0) ,
@@ -5,7 +5,7 @@
 #include "G4SystemOfUnits.hh"
 
 // -- one more nasty trick for new and delete operator overloading:
-G4Allocator<SiDigi_pix> SiDigi_pixAllocator;
+G4ThreadLocal G4Allocator<SiDigi_pix>* SiDigi_pixAllocator = 0;
 
 SiDigi_pix::SiDigi_pix(const int& pix_pn, const int& pix_n) :
 		charge(0) ,
@@ -1,5 +1,6 @@
 
 #include "G4DigiManager.hh"
+#include "Randomize.hh"
 #include "SiDigitizer.hh"
 #include "SiDigi.hh"
 #include "NoiseGenerator.hh"
@@ -10,44 +11,23 @@
 #include <list>
 #include <map>
 #include <iostream>
+#include <algorithm>
+#include <utility>
 
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
 
 #include "TrackerGeometry.hh"
 #include "DiffusionGenerator.hh"
+#include "DetectorPlanes.hh"
 
 //Configuration of digitization
 //Digitization requires several components:
 SiDigitizer::SiDigitizer(G4String aName, G4int strips, G4int planes) :
   G4VDigitizerModule(aName) ,
-  //These two are names for digits and hits collections
+  //Name of the digits collection, the hits collections are named by DetectorPlanes
   digiCollectionName("SiDigitCollection") ,
 
-  hitsCollName_x1("SiStrip_x1") ,
-  hitsCollName_u1("SiStrip_u1") ,
-  hitsCollName_v1("SiStrip_v1") ,
-
-//  hitsCollName_x2("SiStrip_x2") ,
-//  hitsCollName_u2("SiStrip_u2") ,
-//  hitsCollName_v2("SiStrip_v2") ,
-//
-//  hitsCollName_TP1("AirStrip_TP1") ,
-//  hitsCollName_TP2("AirStrip_TP2") ,
-//
-//  hitsCollName_TP3("AirStrip_TP3") ,
-//  hitsCollName_TP4("AirStrip_TP4") ,
-//
-//  hitsCollName_x3("SiStrip_x3") ,
-//  hitsCollName_u3("SiStrip_u3") ,
-//  hitsCollName_v3("SiStrip_v3") ,
-//
-//  hitsCollName_x4("SiStrip_x4") ,
-//  hitsCollName_u4("SiStrip_u4") ,
-//  hitsCollName_v4("SiStrip_v4") ,
-//
-//  hitsCollName_TP5("AirStrip_TP5") ,
-
   digiCollectionStrips(strips) ,
   digiCollectionPlanes(planes) ,
 
@@ -61,9 +41,16 @@ SiDigitizer::SiDigitizer(G4String aName, G4int strips, G4int planes) :
   //noise( 1000. ) ,
   noise( 0.0 ) ,
 
+  // Only strips carrying charge are digitized, noise-only strips above threshold are drawn statistically
+  sparseDigitization( true ) ,
+  noiseThreshold( 0.0 ) ,
+
   // 3 - MeV2Charge converter: converts energy deposits from MeV to Q
   // It needs a parameter: the MeV2Q conversion factor: 3.6 eV/e.
-  convert( 1./(3.6*eV) ) //,
+  convert( 1./(3.6*eV) ) ,
+
+  // Bias voltage of the default DiffusionGenerator
+  diffusionBias( 30.0 ) //,
 
   // 4 - Crosstalk Generator:
   // Cross talk needs fraction of charge that leaks.
@@ -106,524 +93,57 @@ void SiDigitizer::Digitize()
   }
 
 
+  //Number of digits created in each plane
+  std::vector< G4int > nDigits(numPlanes,0);
+
   //Create empty digits
-  for ( G4int plane = 0 ; plane < numPlanes ; ++plane ) {
-    for ( G4int strip = 0 ; strip < numStrips ; ++strip )
-      {
-        SiDigi* newDigi = new SiDigi(plane,strip);
-        //Remember the hit so we can find it by plane,strip
-        digitsMap[plane][strip] = newDigi;
-        //Now insert the digit in the digit collection
-        digiCollection->insert(newDigi);
-      }
+  //In sparse mode they are created on the fly by GetDigi() for the strips that are hit
+  if ( !sparseDigitization ) {
+    for ( G4int plane = 0 ; plane < numPlanes ; ++plane ) {
+      for ( G4int strip = 0 ; strip < numStrips ; ++strip )
+        {
+          GetDigi( digiCollection, digitsMap, plane, strip, nDigits );
+        }
+    }
   }
   //We can now simulate the electronic circuit.
 
   //We search and retrieve the hits collection
   G4DigiManager* digMan = G4DigiManager::GetDMpointer();
     
-  G4int SiHitCollID_x1 = digMan->GetHitsCollectionID( hitsCollName_x1 );//Number associated to hits collection names hitsCollName
-  G4int SiHitCollID_u1 = digMan->GetHitsCollectionID( hitsCollName_u1 );//Number associated to hits collection names hitsCollName
-  G4int SiHitCollID_v1 = digMan->GetHitsCollectionID( hitsCollName_v1 );//Number associated to hits collection names hitsCollName
-  
-//  G4int SiHitCollID_x2 = digMan->GetHitsCollectionID( hitsCollName_x2 );//Number associated to hits collection names hitsCollName
-//  G4int SiHitCollID_u2 = digMan->GetHitsCollectionID( hitsCollName_u2 );//Number associated to hits collection names hitsCollName
-//  G4int SiHitCollID_v2 = digMan->GetHitsCollectionID( hitsCollName_v2 );//Number associated to hits collection names hitsCollName
-//    
-//  G4int SiHitCollID_TP1 = digMan->GetHitsCollectionID( hitsCollName_TP1 );//Number associated to hits collection names hitsCollName
-//  G4int SiHitCollID_TP2 = digMan->GetHitsCollectionID( hitsCollName_TP2 );//Number associated to hits collection names hitsCollName
-//
-//  G4int SiHitCollID_TP3 = digMan->GetHitsCollectionID( hitsCollName_TP3 );//Number associated to hits collection names hitsCollName
-//  G4int SiHitCollID_TP4 = digMan->GetHitsCollectionID( hitsCollName_TP4 );//Number associated to hits collection names hitsCollName
-//    
-//  G4int SiHitCollID_x3 = digMan->GetHitsCollectionID( hitsCollName_x3 );//Number associated to hits collection names hitsCollName
-//  G4int SiHitCollID_u3 = digMan->GetHitsCollectionID( hitsCollName_u3 );//Number associated to hits collection names hitsCollName
-//  G4int SiHitCollID_v3 = digMan->GetHitsCollectionID( hitsCollName_v3 );//Number associated to hits collection names hitsCollName
-//  
-//  G4int SiHitCollID_x4 = digMan->GetHitsCollectionID( hitsCollName_x4 );//Number associated to hits collection names hitsCollName
-//  G4int SiHitCollID_u4 = digMan->GetHitsCollectionID( hitsCollName_u4 );//Number associated to hits collection names hitsCollName
-//  G4int SiHitCollID_v4 = digMan->GetHitsCollectionID( hitsCollName_v4 );//Number associated to hits collection names hitsCollName
-//    
-//  G4int SiHitCollID_TP5 = digMan->GetHitsCollectionID( hitsCollName_TP5 );//Number associated to hits collection names hitsCollName
-    
-  const SiHitCollection* hitCollection_x1 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_x1));
-  const SiHitCollection* hitCollection_u1 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_u1));
-  const SiHitCollection* hitCollection_v1 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_v1));
-
-//  const SiHitCollection* hitCollection_x2 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_x2));
-//  const SiHitCollection* hitCollection_u2 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_u2));
-//  const SiHitCollection* hitCollection_v2 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_v2));
-//
-//  const SiHitCollection* hitCollection_TP1 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_TP1));
-//  const SiHitCollection* hitCollection_TP2 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_TP2));
-//
-//  const SiHitCollection* hitCollection_TP3 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_TP3));
-//  const SiHitCollection* hitCollection_TP4 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_TP4));
-//    
-//  const SiHitCollection* hitCollection_x3 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_x3));
-//  const SiHitCollection* hitCollection_u3 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_u3));
-//  const SiHitCollection* hitCollection_v3 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_v3));
-//  
-//  const SiHitCollection* hitCollection_x4 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_x4));
-//  const SiHitCollection* hitCollection_u4 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_u4));
-//  const SiHitCollection* hitCollection_v4 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_v4));
-//    
-//  const SiHitCollection* hitCollection_TP5 = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID_TP5));
-    
-  //********************************** FIRST TRACKER MODULE **********************************//
-    
-  if(hitCollection_x1)
-    {
-      //G4cout << "Number of hits in x1: " << hitCollection_x1->entries() << G4endl;
-      //G4cout << "\n" << G4endl;
-	  for ( G4int i = 0 ; i < hitCollection_x1->entries() ; ++i )
-        {
-          //For each Hit get which strip it belongs to and convert its edep into charge units
-          SiHit* aHit = (*hitCollection_x1)[i];
-          //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-          G4int hitPlane = aHit->GetPlaneNumber();
-          G4int hitStrip = aHit->GetStripNumber();
-          G4double edep = aHit->GetEdep();
-          G4double charge = convert( edep/MeV );
-          /*G4cout << "x1 The plane from aHit  = " << hitPlane+1;
-          G4cout << ", x1 The strip from aHit  = " << hitStrip;
-          G4cout << ", x1 The charge from aHit  = " << charge << G4endl;*/
-          digitsMap[hitPlane][hitStrip]->Add(charge);
-            
-            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-        }
-    }
-    
-  if(hitCollection_u1)
-    {
-        //G4cout << "Number of hits in u1: " << hitCollection_u1->entries() << G4endl;
-        //G4cout << "\n" << G4endl;
-        for ( G4int i = 0 ; i < hitCollection_u1->entries() ; ++i )
-        {
-          //For each Hit get which strip it belongs to and convert its edep into charge units
-          SiHit* aHit = (*hitCollection_u1)[i];
-          //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-          G4int hitPlane = aHit->GetPlaneNumber();
-          //G4cout << "u1 The plane from aHit  = " << hitPlane << G4endl;
-          G4int hitStrip = aHit->GetStripNumber();
-          G4double edep = aHit->GetEdep();
-          G4double charge = convert( edep/MeV );
-          /*G4cout << "u1 The plane from aHit  = " << hitPlane+1;
-          G4cout << ", u1 The strip from aHit  = " << hitStrip;
-          G4cout << ", u1 The charge from aHit  = " << charge << G4endl;*/
-          digitsMap[hitPlane][hitStrip]->Add(charge);
-            
-            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-        }
-    }
+  // One hits collection per plane, the planes are independent of each other
+  G4bool anyCollection = false;
+  // (plane,strip) of the strips with a hit, the seeds of the charge diffusion
+  std::vector< std::pair< G4int, G4int > > hitStrips;
+  for ( G4int plane = 0 ; plane < numPlanes ; ++plane )
+  {
+    G4int SiHitCollID = digMan->GetHitsCollectionID( DetectorPlanes::StripHitsCollectionName(plane) ); // Number associated to hits collection name
+    if ( SiHitCollID < 0 ) continue;
+    const SiHitCollection* hitCollection = static_cast<const SiHitCollection*>(digMan->GetHitsCollection(SiHitCollID));
+    if ( !hitCollection ) continue;
+    anyCollection = true;
     
-  if(hitCollection_v1)
+    for ( G4int i = 0 ; i < hitCollection->entries() ; ++i )
     {
-        //G4cout << "Number of hits in v1: " << hitCollection_v1->entries() << G4endl;
-        //G4cout << "\n" << G4endl;
-        for ( G4int i = 0 ; i < hitCollection_v1->entries() ; ++i )
-        {
-         //For each Hit get which strip it belongs to and convert its edep into charge units
-         SiHit* aHit = (*hitCollection_v1)[i];
-         //if ( hit->GetIsPrimary() == false ) continue;    //Un-comment primary energy depositions only
-         G4int hitPlane = aHit->GetPlaneNumber();
-         //G4cout << "v1 The plane from aHit  = " << hitPlane << G4endl;
-         G4int hitStrip = aHit->GetStripNumber();
-         G4double edep = aHit->GetEdep();
-         G4double charge = convert( edep/MeV );
-         /*G4cout << "v1 The plane from aHit  = " << hitPlane+1;
-         G4cout << ", v1 The strip from aHit  = " << hitStrip;
-         G4cout << ", v1 The charge from aHit  = " << charge << G4endl;*/
-         digitsMap[hitPlane][hitStrip]->Add(charge);
-            
-            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-        }
+      //For each Hit get which strip it belongs to and convert its edep into charge units
+      SiHit* aHit = (*hitCollection)[i];
+      //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
+      G4int hitPlane = aHit->GetPlaneNumber();
+      G4int hitStrip = aHit->GetStripNumber();
+      G4double edep = aHit->GetEdep();
+      G4double charge = convert( edep/MeV );
+      SiDigi* digi = GetDigi(digiCollection,digitsMap,hitPlane,hitStrip,nDigits);
+      digi->Add(charge);
+      hitStrips.push_back( std::make_pair(hitPlane,hitStrip) );
+      
+      //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
+      //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
+      //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
+      digi->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
     }
+  }
     
-//  //********************************** SECOND TRACKER MODULE **********************************//
-//    
-//    if(hitCollection_x2)
-//    {
-//        //G4cout << "Number of hits in x2: " << hitCollection_x2->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_x2->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_x2)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "x2 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", x2 The strip from aHit  = " << hitStrip;
-//            G4cout << ", x2 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//    }
-//    
-//    if(hitCollection_u2)
-//    {
-//        //G4cout << "Number of hits in u2: " << hitCollection_u2->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_u2->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_u2)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "u2 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", u2 The strip from aHit  = " << hitStrip;
-//            G4cout << ", u2 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//    }
-//    
-//    if(hitCollection_v2)
-//    {
-//        //G4cout << "Number of hits in v2: " << hitCollection_v2->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_v2->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_v2)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;    //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "v2 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", v2 The strip from aHit  = " << hitStrip;
-//            G4cout << ", v2 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//    }
-//
-//  //********************************** TRUTH PLANE 1 **********************************//
-//    
-//    if(hitCollection_TP1)
-//    {
-//        //G4cout << "Number of hits in TP1: " << hitCollection_TP1->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_TP1->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_TP1)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;    //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "TP1 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", TP1 The strip from aHit  = " << hitStrip;
-//            G4cout << ", TP1 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//    }
-//    
-//  //********************************** TRUTH PLANE 2 **********************************//
-//    
-//    if(hitCollection_TP2)
-//    {
-//        //G4cout << "Number of hits in TP2: " << hitCollection_TP2->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_TP2->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_TP2)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;    //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "TP2 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", TP2 The strip from aHit  = " << hitStrip;
-//            G4cout << ", TP2 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//    }
-//
-//    //********************************** TRUTH PLANE 3 **********************************//
-//    
-//    if(hitCollection_TP3)
-//    {
-//        //G4cout << "Number of hits in TP3: " << hitCollection_TP3->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_TP3->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_TP3)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;    //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "TP3 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", TP3 The strip from aHit  = " << hitStrip;
-//            G4cout << ", TP3 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//    }
-//    
-//    //********************************** TRUTH PLANE 4 **********************************//
-//    
-//    if(hitCollection_TP4)
-//    {
-//        //G4cout << "Number of hits in TP4: " << hitCollection_TP4->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_TP4->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_TP4)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;    //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "TP4 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", TP4 The strip from aHit  = " << hitStrip;
-//            G4cout << ", TP4 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//    }
-//    
-//  //********************************** THIRD TRACKER MODULE **********************************//
-//     
-//    if(hitCollection_x3)
-//    {
-//        //G4cout << "Number of hits in x3: " << hitCollection_x3->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_x3->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_x3)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "x3 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", x3 The strip from aHit  = " << hitStrip;
-//            G4cout << ", x3 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//     }
-//    
-//     if(hitCollection_u3)
-//     {
-//        //G4cout << "Number of hits in u3: " << hitCollection_u3->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_u3->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_u3)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "u3 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", u3 The strip from aHit  = " << hitStrip;
-//            G4cout << ", u3 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//     }
-//     
-//     if(hitCollection_v3)
-//     {
-//        //G4cout << "Number of hits in v3: " << hitCollection_v3->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_v3->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_v3)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;    //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "v3 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", v3 The strip from aHit  = " << hitStrip;
-//            G4cout << ", v3 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//     }
-//    
-//  //********************************** FOURTH TRACKER MODULE **********************************//
-//    
-//     if(hitCollection_x4)
-//     {
-//        //G4cout << "Number of hits in x4: " << hitCollection_x4->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_x4->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_x4)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "x4 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", x4 The strip from aHit  = " << hitStrip;
-//            G4cout << ", x4 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//     }
-//    
-//     if(hitCollection_u4)
-//     {
-//        //G4cout << "Number of hits in u4: " << hitCollection_u4->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_u4->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_u4)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "u4 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", u4 The strip from aHit  = " << hitStrip;
-//            G4cout << ", u4 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//     }
-//     
-//     if(hitCollection_v4)
-//     {
-//        //G4cout << "Number of hits in v4: " << hitCollection_v4->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_v4->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_v4)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;    //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "v4 The plane from aHit  = " << hitPlane+1;
-//            G4cout << ", v4 The strip from aHit  = " << hitStrip;
-//            G4cout << ", v4 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//     }
-//    
-//    //********************************** TRUTH PLANE 5 **********************************//
-//    
-//    if(hitCollection_TP5)
-//    {
-//        //G4cout << "Number of hits in TP5: " << hitCollection_TP5->entries() << G4endl;
-//        //G4cout << "\n" << G4endl;
-//        for ( G4int i = 0 ; i < hitCollection_TP5->entries() ; ++i )
-//        {
-//            //For each Hit get which strip it belongs to and convert its edep into charge units
-//            SiHit* aHit = (*hitCollection_TP5)[i];
-//            //if ( hit->GetIsPrimary() == false ) continue;    //Un-comment primary energy depositions only
-//            G4int hitPlane = aHit->GetPlaneNumber();
-//            G4int hitStrip = aHit->GetStripNumber();
-//            G4double edep = aHit->GetEdep();
-//            G4double charge = convert( edep/MeV );
-//            /*G4cout << "TP5 The plane from aHit  = " << hitPlane+1;
-//             G4cout << ", TP5 The strip from aHit  = " << hitStrip;
-//             G4cout << ", TP5 The charge from aHit  = " << charge << G4endl;*/
-//            digitsMap[hitPlane][hitStrip]->Add(charge);
-//            
-//            //This will effectivly set the SiDigi hit_pos as the position of the last sensitive detector hit in the collection
-//            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-//            //the same strip. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-//            digitsMap[hitPlane][hitStrip]->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-//        }
-//    }
-//    
-//  //*******************************************************************************************//
-    
-  if(!hitCollection_x1 && !hitCollection_u1 && !hitCollection_v1
-     /*&& !hitCollection_x2 && !hitCollection_u2 && !hitCollection_v2
-     && !hitCollection_TP1 && !hitCollection_TP2
-     && !hitCollection_TP3 && !hitCollection_TP4
-     && !hitCollection_x3 && !hitCollection_u3 && !hitCollection_v3
-     && !hitCollection_x4 && !hitCollection_u4 && !hitCollection_v4
-     && !hitCollection_TP5*/)
+  if( !anyCollection )
     {
       G4cerr << "Could not find SiHit collection" << G4endl;         //Something really bad happened...
     }
@@ -633,7 +153,23 @@ void SiDigitizer::Digitize()
 
   //MakeCrosstalk( digitsMap );   //Simulate the crosstalk
   
-  MakeDiffusion( digitsMap );   //Simulate the charge diffusion
+  //Charge diffusion moves charge onto the strips next to a hit one, so these need a digit too
+  if ( sparseDigitization )
+  {
+    const size_t nHitDigits = digiCollection->GetSize();
+    for ( size_t d = 0 ; d < nHitDigits ; ++d )
+    {
+      const SiDigi* digi = static_cast< SiDigi* >( digiCollection->GetDigi(d) );
+      const G4int plane = digi->GetPlaneNumber();
+      const G4int strip = digi->GetStripNumber();
+      if ( strip > 0 )             GetDigi( digiCollection, digitsMap, plane, strip-1, nDigits );
+      if ( strip < numStrips-1 )   GetDigi( digiCollection, digitsMap, plane, strip+1, nDigits );
+    }
+  }
+
+  std::sort( hitStrips.begin(), hitStrips.end() );
+  hitStrips.erase( std::unique( hitStrips.begin(), hitStrips.end() ), hitStrips.end() );
+  MakeDiffusion( digitsMap, hitStrips );   //Simulate the charge diffusion
     
   //We can now add, for each strip the noise and pedestal values
   //G4cout << "The no. of digits in the collection is: " << digiCollection->GetSize() << G4endl;
@@ -652,6 +188,9 @@ void SiDigitizer::Digitize()
 
   }
 
+  //Noise-only strips above threshold, the empty ones are not stored
+  if ( sparseDigitization ) { AddNoiseDigits( digiCollection, digitsMap, nDigits ); }
+
   //This line is very important,
   //differently from hits we need to store the digits
   //for each event explicitly.
@@ -664,6 +203,65 @@ void SiDigitizer::Digitize()
   StoreDigiCollection(digiCollection);
 }
 
+SiDigi* SiDigitizer::GetDigi(SiDigiCollection* digiCollection, std::vector< std::vector< SiDigi* > >& digitsMap,
+                             G4int plane, G4int strip, std::vector< G4int >& nDigits)
+{
+  SiDigi*& digi = digitsMap[plane][strip];
+  if ( !digi )
+  {
+    digi = new SiDigi(plane,strip);
+    //Now insert the digit in the digit collection
+    digiCollection->insert(digi);
+    ++nDigits[plane];
+  }
+  return digi;
+}
+
+void SiDigitizer::AddNoiseDigits(SiDigiCollection* digiCollection, std::vector< std::vector< SiDigi* > >& digitsMap,
+                                 std::vector< G4int >& nDigits)
+{
+  //Threshold on the noise alone, the pedestal is always there
+  const G4double noiseOnlyThreshold = noiseThreshold - pedestal;
+  const G4double prob = noise.ProbabilityAbove( noiseOnlyThreshold );
+  if ( prob <= 0. ) return;
+
+  for ( size_t plane = 0 ; plane < digitsMap.size() ; ++plane )
+  {
+    std::vector< SiDigi* >& thisPlane = digitsMap[plane];
+    const G4int nStrips = thisPlane.size();
+    const G4int nEmpty = nStrips - nDigits[plane];
+    if ( nEmpty <= 0 ) continue;
+
+    //Expected number of empty strips that the noise pushes over threshold
+    G4int nNoise = CLHEP::RandBinomial::shoot( nEmpty , prob );
+    if ( nNoise == 0 ) continue;
+
+    if ( 2*nNoise > nEmpty )
+    {
+      //Threshold below the noise level: most strips fire anyway, go through them all and pick
+      //exactly nNoise of the empty ones, each remaining one with probability nNoise/nLeft (selection sampling)
+      G4int nLeft = nEmpty;
+      for ( G4int strip = 0 ; strip < nStrips && nNoise > 0 ; ++strip )
+      {
+        if ( thisPlane[strip] ) continue;
+        if ( G4UniformRand()*nLeft-- >= nNoise ) continue;
+        GetDigi( digiCollection, digitsMap, plane, strip, nDigits )->Add( pedestal + noise.FireAbove( noiseOnlyThreshold ) );
+        --nNoise;
+      }
+      continue;
+    }
+
+    //Place them on random empty strips
+    while ( nNoise > 0 )
+    {
+      G4int strip = static_cast<G4int>( G4UniformRand()*nStrips );
+      if ( strip >= nStrips || thisPlane[strip] ) continue;
+      GetDigi( digiCollection, digitsMap, plane, strip, nDigits )->Add( pedestal + noise.FireAbove( noiseOnlyThreshold ) );
+      --nNoise;
+    }
+  }
+}
+
 /*
 void SiDigitizer::MakeCrosstalk(std::vector< std::vector< SiDigi* > >& digitsMap )
 {
@@ -689,193 +287,82 @@ void SiDigitizer::MakeCrosstalk(std::vector< std::vector< SiDigi* > >& digitsMap
 }
 */
 
-void SiDigitizer::MakeDiffusion(std::vector< std::vector< SiDigi* > >& digitsMap )
+void SiDigitizer::ReSetSensorGeometry( const G4int& nStrips, const G4double& pitch, const G4double& length, const G4double& thickness,
+                                       const std::vector<G4ThreeVector>& positions, const std::vector<G4double>& angles )
+{
+  //TrackerGeometry works in mm
+  const G4bool sensorChanged = !( nStrips == tracker.get_strips() && pitch/mm == tracker.get_s_pitch() &&
+                                  length/mm == tracker.get_s_length() && thickness/mm == tracker.get_thickness() );
+  if ( !sensorChanged && positions == planePositions && angles == planeAngles ) return;
+  
+  if ( sensorChanged )
+  {
+    tracker = TrackerGeometry( nStrips, pitch/mm, length/mm, thickness/mm );
+    diffusion = DiffusionGenerator( diffusionBias, tracker.get_thickness() );
+  }
+  
+  //The default placement of TrackerGeometry is replaced by the one of DetectorConstruction (/det/ macros)
+  planePositions = positions;
+  planeAngles = angles;
+  const size_t nPlanes = std::min( positions.size(), static_cast<size_t>( tracker.get_nb_of_planes() ) );
+  for ( size_t plane = 0 ; plane < nPlanes ; ++plane )
+  {
+    const G4ThreeVector& pos = positions[plane];
+    tracker.set_plane_placement( plane, TVector3( pos.x()/mm, pos.y()/mm, pos.z()/mm ), angles[plane]/rad );
+  }
+}
+
+void SiDigitizer::MakeDiffusion(std::vector< std::vector< SiDigi* > >& digitsMap,
+                                const std::vector< std::pair< G4int, G4int > >& hitStrips )
 {
-    double *lim;
     double limits[2], dist_to_hit, charge_frac, seed_charge;
-    TVector3 strip_origin, det_origin, det_opp_origin;
+    const double s_pitch = tracker.get_s_pitch();
     
-    for(int hit_plane = 0; hit_plane < digiCollectionPlanes; ++hit_plane)
+    //The seeds are taken in the order of the former scan over all strips (plane by plane, increasing strip no.)
+    //because the charge diffused onto a hit strip is diffused again when that strip is used as a seed
+    for ( size_t h = 0 ; h < hitStrips.size() ; ++h )
     {
+        const int hit_plane = hitStrips[h].first;
+        const int strip = hitStrips[h].second + 1;      //strips numbered from 1 below
+        
+        //Planes of TrackerGeometry in the order of DetectorPlanes: x1,u1,v1,x2,...
+        if ( hit_plane >= tracker.get_nb_of_planes() )
+        {
+            G4cout << "plane " << DetectorPlanes::StripPlaneName(hit_plane) << " does not exist for charge sharing!" << G4endl;
+            continue;
+        }
+        const TrackerGeometry::PlaneTransform& geometry = tracker.get_plane(hit_plane);
+        const int nStrips = std::min( static_cast<int>(geometry.strip_pos.size()), static_cast<int>(digitsMap[hit_plane].size()) );
+        if ( strip > nStrips ) continue;
+        
         std::vector< SiDigi* >& thisPlane = digitsMap[hit_plane]; //could use digitsMap directy but this is slightly faster
+        SiDigi* seed = thisPlane[strip-1];
+        if ( !seed ) continue;
+        
+        seed_charge = seed->GetCharge();
+        
+        //Strips that only received charge from diffusion have the default hit position of (0,0,z): their charge is not
+        //diffused again, ie we ensure charge diffusion only occurs away from the hit not towards it.
+        if ( !(seed_charge > 0 && seed->GetPos().x() != 0 && seed->GetPos().y() != 0) ) continue;
         
-        for (int strip=1; strip <= tracker.get_strips(); ++strip )
+        //Integrate over ONE strip either side of hit strip
+        //Set integration limits for charge diffusion, one strip either side of
+        //seed should be sufficient since diffusion sigma is only 5-6um. therefore +/- pitch is equal to +/- 13sigma!
+        int s_rng_l = ( strip > 1 ) ? (strip - 1) : 1;
+        int s_rng_h = ( strip < nStrips ) ? (strip + 1) : nStrips;
+        
+        //Distance of the hit along the detector axis, so that the integral limits set by the strip boundaries are
+        //independant of the detector orientaion/rotation (see TrackerGeometry::world_2_det_transform)
+        dist_to_hit = tracker.world_2_det(hit_plane, seed->GetPos().X(), seed->GetPos().Y());
+        
+        for(int i=s_rng_l; i<=s_rng_h; i++)
         {
-            seed_charge = thisPlane[strip-1]->GetCharge();
+            if ( !thisPlane[i-1] ) continue;
             
-            //All strips have default initialised hit position of (0,0,z), thus if a strip contains charge but x = y = 0 then
-            //we know that it has no hit on it and has recieved charge from diffusion. this prevents us from diffusing charge
-            //that is present from charge diffusion, ie we ensure charge diffusion only occurs away from the hit not towards it.
-            if(seed_charge>0 && thisPlane[strip-1]->GetPos().x() != 0 && thisPlane[strip-1]->GetPos().y() != 0)
-            {
-                //Integrate over ONE strip either side of hit strip
-                //Set integration limits for charge diffusion, one strip either side of
-                //seed should be sufficient since diffusion sigma is only 5-6um. therefore +/- pitch is equal to +/- 13sigma!
-                int s_rng_l = ( strip > 1 ) ? (strip - 1) : 1;
-                int s_rng_h = ( strip < tracker.get_strips() ) ? (strip + 1) : tracker.get_strips();
-                
-                //Integrate over TWO strips either side of hit strip
-                //int s_rng_l = ( strip > 2 ) ? (strip - 2) : 1;
-                //int s_rng_h = ( strip < tracker.get_strips() - 1 ) ? (strip + 2) : tracker.get_strips();
-                
-                //For debug
-                /*G4cout << "*************************************************************************\n" << G4endl;
-                G4cout << "Before charge diffusion.." << " plane = " << hit_plane + 1 << ", seed strip = " << strip << G4endl;
-                G4cout << "charge on seed strip - 1 = " << thisPlane[strip-2]->GetCharge() << " e-" << G4endl;
-                G4cout << "charge on seed strip = " << seed_charge << " e- (SEED strip)" << G4endl;
-                G4cout << "charge on seed strip + 1 = " << thisPlane[strip]->GetCharge() << " e-\n" << G4endl;*/
-                
-                for(int i=s_rng_l; i<=s_rng_h; i++)
-                {
-                    switch (hit_plane)
-                    {
-                        case 0:
-                            //cout << "for x1"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_x1(), i , tracker.get_stereo_x1());
-                            det_origin = tracker.get_A_x1();
-                            det_opp_origin = tracker.get_D_x1();
-                            break;
-                            
-                        case 1:
-                            //cout << "for u1"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_u1(), i , tracker.get_stereo_u1());
-                            det_origin = tracker.get_A_u1();
-                            det_opp_origin = tracker.get_D_u1();
-                            break;
-                            
-                        case 2:
-                            //cout << "for v1"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_v1(), i , tracker.get_stereo_v1());
-                            det_origin = tracker.get_A_v1();
-                            det_opp_origin = tracker.get_D_v1();
-                            break;
-                            
-                        case 3:
-                            //cout << "for x2"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_x2(), i , tracker.get_stereo_x2());
-                            det_origin = tracker.get_A_x2();
-                            det_opp_origin = tracker.get_D_x2();
-                            break;
-                            
-                        case 4:
-                            //cout << "for u2"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_u2(), i , tracker.get_stereo_u2());
-                            det_origin = tracker.get_A_u2();
-                            det_opp_origin = tracker.get_D_u2();
-                            break;
-                            
-                        case 5:
-                            //cout << "for v2"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_v2(), i , tracker.get_stereo_v2());
-                            det_origin = tracker.get_A_v2();
-                            det_opp_origin = tracker.get_D_v2();
-                            break;
-                            
-                        case 6:
-                            //cout << "for TP1" << endl; //No charge sharing for truth planes
-                            break;
-                            
-                        case 7:
-                            //cout << "for TP2" << endl; //No charge sharing for truth planes
-                            break;
-                            
-                        case 8:
-                            //cout << "for TP3" << endl; //No charge sharing for truth planes
-                            break;
-                            
-                        case 9:
-                            //cout << "for TP4" << endl; //No charge sharing for truth planes
-                            break;
-
-                        case 10:
-                            //cout << "for x3"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_x3(), i , tracker.get_stereo_x3());
-                            det_origin = tracker.get_A_x3();
-                            det_opp_origin = tracker.get_D_x3();
-                            break;
-                            
-                        case 11:
-                            //cout << "for u3"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_u3(), i , tracker.get_stereo_u3());
-                            det_origin = tracker.get_A_u3();
-                            det_opp_origin = tracker.get_D_u3();
-                            break;
-                            
-                        case 12:
-                            //cout << "for v3"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_v3(), i , tracker.get_stereo_v3());
-                            det_origin = tracker.get_A_v3();
-                            det_opp_origin = tracker.get_D_v3();
-                            break;
-                            
-                        case 13:
-                            //cout << "for x4"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_x4(), i , tracker.get_stereo_x4());
-                            det_origin = tracker.get_A_x4();
-                            det_opp_origin = tracker.get_D_x4();
-                            break;
-                            
-                        case 14:
-                            //cout << "for u4"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_u4(), i , tracker.get_stereo_u4());
-                            det_origin = tracker.get_A_u4();
-                            det_opp_origin = tracker.get_D_u4();
-                            break;
-                            
-                        case 15:
-                            //cout << "for v4"<< endl;
-                            strip_origin = tracker.get_strip_origin(tracker.get_A_v4(), i , tracker.get_stereo_v4());
-                            det_origin = tracker.get_A_v4();
-                            det_opp_origin = tracker.get_D_v4();
-                            break;
-                            
-                        case 16:
-                            //cout << "for TP5" << endl; //No charge sharing for truth planes
-                            break;
-                            
-                        default:
-                            G4cout << "plane does not exist for charge sharing!" << G4endl;
-                            break;
-                    }
-                    
-                    //Exclude the truth planes or their charge will be reduced to zero by the charge sharing functions below
-                    //this will result in no strip numbers being recorded for the hits by the RootSaver object
-                    if(hit_plane != 6 && hit_plane != 7 && hit_plane != 8 && hit_plane != 9 && hit_plane != 16)
-                    {
-                        //Find distance from detector origin to hit so that integral limits set by strip boundaries can be found in detector co-ordinates
-                        //ie integration limits will be independant of detector orientaion/rotation. Strips that contain charge but no hit ie strips that
-                        //have charge diffused onto them from a hit strip will be processed but have a hit pos = 0.0 giving a dist_to_hit = det_size/2
-                        //for which the erf() will nearly always return zero preventing the charge gained by diffusion from being diffused again.
-                        dist_to_hit = tracker.world_2_det_transform(det_origin, det_opp_origin, digitsMap[hit_plane][strip-1]->GetPos());
-                        lim = diffusion.get_igral_limits(limits,tracker.world_2_det_transform(det_origin, det_opp_origin, strip_origin),
-                                                                 dist_to_hit,tracker.get_s_pitch());
-                        
-                        //Modify the charge distribution on each strip
-                        charge_frac = diffusion.get_charge_frac(lim);
-                        //thisPlane[i-1]->SetCharge( thisPlane[i-1]->GetCharge() + seed_charge * charge_frac );
-                        if(i == strip) thisPlane[i-1]->SetCharge( seed_charge * charge_frac );
-                        if(i != strip) thisPlane[i-1]->SetCharge( thisPlane[i-1]->GetCharge() + seed_charge * charge_frac );
-                        
-                        //For debug
-                        /*G4cout << "hit location = (" << digitsMap[hit_plane][strip-1]->GetPos().x() << ","
-                        << digitsMap[hit_plane][strip-1]->GetPos().y() << ","
-                        << digitsMap[hit_plane][strip-1]->GetPos().z() << ")" << G4endl;
-                        G4cout << "dist_to_hit = " << dist_to_hit << G4endl;
-                        G4cout << "distance from hit to strip boundary: " << limits[0] << " and " << limits[1] << " diff = " << limits[1] - limits[0] << G4endl;
-                        G4cout << "finished charge diffusion for strip: " << i << G4endl;*/
-
-                    }
-                    
-                }
-                
-                //For debug
-                /*G4cout << "\nAfter ALL charge diffusion.." << " plane = " << hit_plane + 1 << ", strip = " << strip << G4endl;
-                G4cout << "charge on seed strip - 1 = " << thisPlane[strip-2]->GetCharge() << " e-" << G4endl;
-                G4cout << "charge on seed strip = " << thisPlane[strip-1]->GetCharge() << " e- (SEED strip)" << G4endl;
-                G4cout << "charge on seed strip + 1 = " << thisPlane[strip]->GetCharge() << " e-\n" << G4endl;*/
-            }
+            //Modify the charge distribution on each strip
+            charge_frac = diffusion.get_charge_frac( diffusion.get_igral_limits(limits, geometry.strip_pos[i-1], dist_to_hit, s_pitch) );
+            if(i == strip) thisPlane[i-1]->SetCharge( seed_charge * charge_frac );
+            if(i != strip) thisPlane[i-1]->SetCharge( thisPlane[i-1]->GetCharge() + seed_charge * charge_frac );
         }
-        
     }
-    
 }
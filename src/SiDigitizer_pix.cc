@@ -8,11 +8,13 @@
 #include "SiDigi_pix.hh"
 #include "SiDigitizer_pix.hh"
 #include "SiHit_pix.hh"
+#include "DetectorPlanes.hh"
 #include "NoiseGenerator.hh"
 #include "MeV2ChargeConverter.hh"
 #include "CrosstalkGenerator.hh"
 
 #include "G4DigiManager.hh"
+#include "Randomize.hh"
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
 
@@ -20,14 +22,9 @@
 //Configuration of digitization, digitization requires several components:
 SiDigitizer_pix::SiDigitizer_pix(G4String aName, G4int pixel, G4int pl) :
   G4VDigitizerModule(aName) ,
-  //These two are names for digits and hits collections
+  //Name of the digits collection, the hits collections are named by DetectorPlanes
   digiCollectionName("SiDigitCollection_pix") ,
 
-  hitsCollName_pix1("SiPixel_pix1") ,
-  hitsCollName_pix2("SiPixel_pix2") ,
-  hitsCollName_pix3("SiPixel_pix3") ,
-  hitsCollName_pix4("SiPixel_pix4") ,
-
   digiCollectionPixels(pixel),
   digiCollectionPlanes(pl),
 
@@ -41,6 +38,10 @@ SiDigitizer_pix::SiDigitizer_pix(G4String aName, G4int pixel, G4int pl) :
   //noise( 1000. ) ,
   noise( 0.0 ) ,
 
+  // Only pixels carrying charge are digitized, noise-only pixels above threshold are drawn statistically
+  sparseDigitization( true ) ,
+  noiseThreshold( 0.0 ) ,
+
   // 3 - MeV2Charge converter: converts energy deposits from MeV to Q
   // It needs a parameter: the MeV2Q conversion factor: 3.6 eV/e.
   convert( 1./(3.6*eV) ) //,
@@ -86,144 +87,55 @@ void SiDigitizer_pix::Digitize()
   }
 
  
+  // Number of digits created in each plane
+  std::vector< G4int > nDigits(numPlanes,0);
+ 
   // Create empty digits
+  // In sparse mode they are created on the fly by GetDigi() for the pixels that are hit
   //G4cout << "\nnumPlanes = " << numPlanes << ", numPixels = " << numPixels << "\n" << G4endl;
-  for ( G4int plane = 0 ; plane < numPlanes ; ++plane ) {
-    for ( G4int pixel = 0 ; pixel < numPixels ; ++pixel )
-      {
-        SiDigi_pix* newDigi = new SiDigi_pix(plane,pixel);
-        // Remember the hit so we can find it by plane,pixel
-        digitsMap[plane][pixel] = newDigi;
-        // Now insert the digit in the digit collection
-        digiCollection->insert(newDigi);
-      }
+  if ( !sparseDigitization ) {
+    for ( G4int plane = 0 ; plane < numPlanes ; ++plane ) {
+      for ( G4int pixel = 0 ; pixel < numPixels ; ++pixel )
+        {
+          GetDigi( digiCollection, digitsMap, plane, pixel, nDigits );
+        }
+    }
   }
   // We can now simulate the electronic circuit.
 
   //We search and retrieve the hits collection
   G4DigiManager* digMan = G4DigiManager::GetDMpointer();
     
-  G4int SiHitCollID_pix1 = digMan->GetHitsCollectionID( hitsCollName_pix1 ); // Number associated to hits collection names hitsCollName
-  G4int SiHitCollID_pix2 = digMan->GetHitsCollectionID( hitsCollName_pix2 ); // Number associated to hits collection names hitsCollName
-  G4int SiHitCollID_pix3 = digMan->GetHitsCollectionID( hitsCollName_pix3 ); // Number associated to hits collection names hitsCollName
-  G4int SiHitCollID_pix4 = digMan->GetHitsCollectionID( hitsCollName_pix4 ); // Number associated to hits collection names hitsCollName
-    
-  const SiHit_pixCollection* hitCollection_pix1 = static_cast<const SiHit_pixCollection*>(digMan->GetHitsCollection(SiHitCollID_pix1));
-  const SiHit_pixCollection* hitCollection_pix2 = static_cast<const SiHit_pixCollection*>(digMan->GetHitsCollection(SiHitCollID_pix2));
-  const SiHit_pixCollection* hitCollection_pix3 = static_cast<const SiHit_pixCollection*>(digMan->GetHitsCollection(SiHitCollID_pix3));
-  const SiHit_pixCollection* hitCollection_pix4 = static_cast<const SiHit_pixCollection*>(digMan->GetHitsCollection(SiHitCollID_pix4));
-
-  //********************************** FIRST TRACKER MODULE **********************************//
-    
-    if(hitCollection_pix1)
-    {
-      //G4cout << "Number of hits in pix1: " << hitCollection_pix1->entries() << G4endl;
-      //G4cout << "\n" << G4endl;
-	  for ( G4int i = 0 ; i < hitCollection_pix1->entries() ; ++i )
-        {
-            //For each Hit get which pixel it belongs to and convert its edep into charge units
-            SiHit_pix* aHit = (*hitCollection_pix1)[i];
-            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-            G4int hitPlane = aHit->GetPlaneNumber();
-            G4int hitPixel = aHit->GetPixelNumber();
-            G4double edep = aHit->GetEdep();
-            G4double charge = convert( edep/MeV );
-            /*G4cout << "pix1 The plane from aHit  = " << hitPlane+1;
-            G4cout << ", pix1 The pixel from aHit  = " << hitPixel;
-            G4cout << ", pix1 The charge from aHit  = " << charge << G4endl;*/
-            digitsMap.at(hitPlane).at(hitPixel)->Add(charge);
-            
-            //This will effectivly set the SiDigi_pix hit_pos as the position of the last sensitive detector hit in the collection
-            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-            //the same pixel. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-            digitsMap.at(hitPlane).at(hitPixel)->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-        }
-    }
-    
-    
-    //********************************** SECOND TRACKER MODULE **********************************//
-    
-    if(hitCollection_pix2)
-    {
-        //G4cout << "Number of hits in pix2: " << hitCollection_pix2->entries() << G4endl;
-        //G4cout << "\n" << G4endl;
-        for ( G4int i = 0 ; i < hitCollection_pix2->entries() ; ++i )
-        {
-            //G4cout << "Digitise stage 0"<< G4endl;
-            //For each Hit get which pixel it belongs to and convert its edep into charge units
-            SiHit_pix* aHit = (*hitCollection_pix2)[i];  //G4cout << "Digitise stage 1"<< G4endl;
-            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-            G4int hitPlane = aHit->GetPlaneNumber(); //G4cout << "Digitise stage 2"<< G4endl;
-            //G4cout << "u1 The plane from aHit  = " << hitPlane << G4endl;
-            G4int hitPixel = aHit->GetPixelNumber();  //G4cout << "Digitise stage 3"<< G4endl;
-            G4double edep = aHit->GetEdep(); //G4cout << "Digitise stage 4"<< G4endl;
-            G4double charge = convert( edep/MeV ); //G4cout << "Digitise stage 5"<< G4endl;
-            /*G4cout << "pix2 The plane from aHit  = " << hitPlane+1;
-            G4cout << ", pix2 The pixel from aHit  = " << hitPixel;
-            G4cout << ", pix2 The charge from aHit  = " << charge << G4endl;*/
-            digitsMap.at(hitPlane).at(hitPixel)->Add(charge); //G4cout << "Digitise stage 6"<< G4endl;
-            
-            //This will effectivly set the SiDigi_pix hit_pos as the position of the last sensitive detector hit in the collection
-            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-            //the same pixel. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-            digitsMap.at(hitPlane).at(hitPixel)->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-        }
-    }
-    
-    
-    //********************************** THIRD TRACKER MODULE **********************************//
-    
-    if(hitCollection_pix3)
-    {
-        //G4cout << "Number of hits in pix3: " << hitCollection_pix3->entries() << G4endl;
-        //G4cout << "\n" << G4endl;
-        for ( G4int i = 0 ; i < hitCollection_pix3->entries() ; ++i )
-        {
-            //G4cout << "Digitise stage 0"<< G4endl;
-            //For each Hit get which pixel it belongs to and convert its edep into charge units
-            SiHit_pix* aHit = (*hitCollection_pix3)[i];
-            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-            G4int hitPlane = aHit->GetPlaneNumber();
-            G4int hitPixel = aHit->GetPixelNumber();
-            G4double edep = aHit->GetEdep();
-            G4double charge = convert( edep/MeV );
-            digitsMap.at(hitPlane).at(hitPixel)->Add(charge);
-            
-            //This will effectivly set the SiDigi_pix hit_pos as the position of the last sensitive detector hit in the collection
-            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-            //the same pixel. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-            digitsMap.at(hitPlane).at(hitPixel)->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-        }
-    }
-    
-    //********************************** FOURTH TRACKER MODULE **********************************//
+  // One hits collection per plane, the planes are independent of each other
+  G4bool anyCollection = false;
+  for ( G4int plane = 0 ; plane < numPlanes ; ++plane )
+  {
+    G4int SiHitCollID = digMan->GetHitsCollectionID( DetectorPlanes::PixelHitsCollectionName(plane) ); // Number associated to hits collection name
+    if ( SiHitCollID < 0 ) continue;
+    const SiHit_pixCollection* hitCollection = static_cast<const SiHit_pixCollection*>(digMan->GetHitsCollection(SiHitCollID));
+    if ( !hitCollection ) continue;
+    anyCollection = true;
     
-    if(hitCollection_pix4)
+    for ( G4int i = 0 ; i < hitCollection->entries() ; ++i )
     {
-        //G4cout << "Number of hits in pix4: " << hitCollection_pix4->entries() << G4endl;
-        //G4cout << "\n" << G4endl;
-        for ( G4int i = 0 ; i < hitCollection_pix4->entries() ; ++i )
-        {
-            //G4cout << "Digitise stage 0"<< G4endl;
-            //For each Hit get which pixel it belongs to and convert its edep into charge units
-            SiHit_pix* aHit = (*hitCollection_pix4)[i];
-            //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
-            G4int hitPlane = aHit->GetPlaneNumber();
-            G4int hitPixel = aHit->GetPixelNumber();
-            G4double edep = aHit->GetEdep();
-            G4double charge = convert( edep/MeV );
-            digitsMap.at(hitPlane).at(hitPixel)->Add(charge);
-            
-            //This will effectivly set the SiDigi_pix hit_pos as the position of the last sensitive detector hit in the collection
-            //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
-            //the same pixel. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
-            digitsMap.at(hitPlane).at(hitPixel)->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
-        }
+      //For each Hit get which pixel it belongs to and convert its edep into charge units
+      SiHit_pix* aHit = (*hitCollection)[i];
+      //if ( hit->GetIsPrimary() == false ) continue;   //Un-comment primary energy depositions only
+      G4int hitPlane = aHit->GetPlaneNumber();
+      G4int hitPixel = aHit->GetPixelNumber();
+      G4double edep = aHit->GetEdep();
+      G4double charge = convert( edep/MeV );
+      SiDigi_pix* digi = GetDigi(digiCollection,digitsMap,hitPlane,hitPixel,nDigits);
+      digi->Add(charge);
+      
+      //This will effectivly set the SiDigi_pix hit_pos as the position of the last sensitive detector hit in the collection
+      //This should be accurate enough for charge diffusion as all hits will be in close proximity provided they occur on
+      //the same pixel. G4ThreeVector converted to TVector3 to allow processing by MakeDiffusion function.
+      digi->SetPos(TVector3(aHit->GetPosition().x(),aHit->GetPosition().y(),aHit->GetPosition().z()));
     }
+  }
     
-  //*******************************************************************************************//
-    
-  if(!hitCollection_pix1 && !hitCollection_pix2 && !hitCollection_pix3 && !hitCollection_pix4)
+  if( !anyCollection )
     {
       G4cerr << "Could not find SiHit_pix collection" << G4endl;         //Something really bad happened...
     }
@@ -252,6 +164,9 @@ void SiDigitizer_pix::Digitize()
 
   }
 
+  //Noise-only pixels above threshold, the empty ones are not stored
+  if ( sparseDigitization ) { AddNoiseDigits( digiCollection, digitsMap, nDigits ); }
+
   //This line is very important,
   //differently from hits we need to store the digits
   //for each event explicitly.
@@ -264,6 +179,65 @@ void SiDigitizer_pix::Digitize()
   StoreDigiCollection(digiCollection);
 }
 
+SiDigi_pix* SiDigitizer_pix::GetDigi(SiDigi_pixCollection* digiCollection, std::vector< std::vector< SiDigi_pix* > >& digitsMap,
+                                     G4int plane, G4int pixel, std::vector< G4int >& nDigits)
+{
+  SiDigi_pix*& digi = digitsMap[plane][pixel];
+  if ( !digi )
+  {
+    digi = new SiDigi_pix(plane,pixel);
+    // Now insert the digit in the digit collection
+    digiCollection->insert(digi);
+    ++nDigits[plane];
+  }
+  return digi;
+}
+
+void SiDigitizer_pix::AddNoiseDigits(SiDigi_pixCollection* digiCollection, std::vector< std::vector< SiDigi_pix* > >& digitsMap,
+                                     std::vector< G4int >& nDigits)
+{
+  //Threshold on the noise alone, the pedestal is always there
+  const G4double noiseOnlyThreshold = noiseThreshold - pedestal;
+  const G4double prob = noise.ProbabilityAbove( noiseOnlyThreshold );
+  if ( prob <= 0. ) return;
+
+  for ( size_t plane = 0 ; plane < digitsMap.size() ; ++plane )
+  {
+    std::vector< SiDigi_pix* >& thisPlane = digitsMap[plane];
+    const G4int nPixels = thisPlane.size();
+    const G4int nEmpty = nPixels - nDigits[plane];
+    if ( nEmpty <= 0 ) continue;
+
+    //Expected number of empty pixels that the noise pushes over threshold
+    G4int nNoise = CLHEP::RandBinomial::shoot( nEmpty , prob );
+    if ( nNoise == 0 ) continue;
+
+    if ( 2*nNoise > nEmpty )
+    {
+      //Threshold below the noise level: most pixels fire anyway, go through them all and pick
+      //exactly nNoise of the empty ones, each remaining one with probability nNoise/nLeft (selection sampling)
+      G4int nLeft = nEmpty;
+      for ( G4int pixel = 0 ; pixel < nPixels && nNoise > 0 ; ++pixel )
+      {
+        if ( thisPlane[pixel] ) continue;
+        if ( G4UniformRand()*nLeft-- >= nNoise ) continue;
+        GetDigi( digiCollection, digitsMap, plane, pixel, nDigits )->Add( pedestal + noise.FireAbove( noiseOnlyThreshold ) );
+        --nNoise;
+      }
+      continue;
+    }
+
+    //Place them on random empty pixels
+    while ( nNoise > 0 )
+    {
+      G4int pixel = static_cast<G4int>( G4UniformRand()*nPixels );
+      if ( pixel >= nPixels || thisPlane[pixel] ) continue;
+      GetDigi( digiCollection, digitsMap, plane, pixel, nDigits )->Add( pedestal + noise.FireAbove( noiseOnlyThreshold ) );
+      --nNoise;
+    }
+  }
+}
+
 /*
 void SiDigitizer_pix::MakeCrosstalk(std::vector< std::vector< SiDigi* > >& digitsMap )
 {
@@ -5,7 +5,7 @@
 #include "G4SystemOfUnits.hh"
 
 // -- one more nasty trick for new and delete operator overloading:
-G4Allocator<SiHit> SiHitAllocator;
+G4ThreadLocal G4Allocator<SiHit>* SiHitAllocator = 0;
 
 SiHit::SiHit(const G4int strip, const G4int plane, const G4bool primary, G4int track)
   : stripNumber(strip), planeNumber(plane), trackNumber(track), isPrimary(primary) // <<-- note BTW this is the only way to initialize a "const" member
@@ -5,13 +5,14 @@
 #include "G4SystemOfUnits.hh"
 
 // -- one more nasty trick for new and delete operator overloading:
-G4Allocator<SiHit_pix> SiHit_pixAllocator;
+G4ThreadLocal G4Allocator<SiHit_pix>* SiHit_pixAllocator = 0;
 
 SiHit_pix::SiHit_pix(const G4int pixel, const G4int plane, const G4bool primary, G4int track)
   : pixelNumber(pixel), planeNumber(plane), trackNumber(track), isPrimary(primary) // <<-- note BTW this is the only way to initialize a "const" member
 {
   eDep     = 0.0;
   ni_eDep  = 0.0;
+  weight   = 1.0;
 }
 
 SiHit_pix::~SiHit_pix()
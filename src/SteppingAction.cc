@@ -11,24 +11,46 @@
 
 #include "TSystem.h"
 #include "DetectorConstruction.hh"
+#include "PhaseSpaceWriter.hh"
+
+#include "G4Event.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
 
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-SteppingAction::SteppingAction(/*G4VUserDetectorConstruction* myDC*/)
+SteppingAction::SteppingAction(/*G4VUserDetectorConstruction* myDC*/ PhaseSpaceWriter* phsp) :
+    phaseSpace(phsp)
 {
 
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-//void SteppingAction::UserSteppingAction( const G4Step* aStep  )
-//{
-//
-//  //Can be used to write step by step particle track info to output ascii file
-//}
+void SteppingAction::UserSteppingAction( const G4Step* aStep  )
+{
+  //Can be used to write step by step particle track info to output ascii file
+
+  if ( !phaseSpace || !phaseSpace->IsOpen() ) return;
+
+  // Phase-space scoring: the particle crosses a boundary from outside into
+  // the converter film or a sensor plane
+  const G4StepPoint* postStep = aStep->GetPostStepPoint();
+  if ( postStep->GetStepStatus() != fGeomBoundary ) return;
+  const G4VPhysicalVolume* postVolume = postStep->GetPhysicalVolume();
+  if ( !postVolume ) return;
+  if ( !phaseSpace->IsInside( postVolume->GetLogicalVolume()->GetRegion() ) ) return;
+  if ( phaseSpace->IsInside( aStep->GetPreStepPoint()->GetPhysicalVolume()->GetLogicalVolume()->GetRegion() ) ) return;
+
+  G4Track* track = aStep->GetTrack();
+  phaseSpace->Fill( G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID(), track );
+  if ( phaseSpace->GetKillRecorded() ) {track->SetTrackStatus( fStopAndKill );}
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
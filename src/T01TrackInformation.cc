@@ -2,7 +2,7 @@
 #include "T01TrackInformation.hh"
 #include "G4ios.hh"
 
-G4Allocator<T01TrackInformation> aTrackInformationAllocator;
+G4ThreadLocal G4Allocator<T01TrackInformation>* aTrackInformationAllocator = 0;
 
 
 
@@ -16,6 +16,8 @@ T01TrackInformation::T01TrackInformation()
      kineticEnergy = 0.; //**********implement the K.E for the particles
      originalTime = 0.;
      parent_ID = 0;
+     vertexPosition = G4ThreeVector(0.,0.,0.);
+     vertexKineticEnergy = 0.;
 }
 
 T01TrackInformation::T01TrackInformation(const G4Track* aTrack)
@@ -27,6 +29,8 @@ T01TrackInformation::T01TrackInformation(const G4Track* aTrack)
      kineticEnergy = aTrack->GetKineticEnergy();//**********************
      originalEnergy = aTrack->GetTotalEnergy();
      originalTime = aTrack->GetGlobalTime();
+     vertexPosition = aTrack->GetVertexPosition();
+     vertexKineticEnergy = aTrack->GetVertexKineticEnergy();
         particleName = particleDefinition -> GetParticleName(); 
      //particleName = DynamicParticle -> GetParticleName(); 
 
@@ -47,6 +51,8 @@ T01TrackInformation::T01TrackInformation(const T01TrackInformation* aTrackInfo)
     originalEnergy = aTrackInfo->originalEnergy;
     kineticEnergy = aTrackInfo->kineticEnergy; //*********************
     originalTime = aTrackInfo->originalTime;
+    vertexPosition = aTrackInfo->vertexPosition;
+    vertexKineticEnergy = aTrackInfo->vertexKineticEnergy;
      parent_ID = aTrackInfo->parent_ID;
        particleName = particleDefinition-> GetParticleName(); 
        // particleName = DynamicParticle-> GetParticleName(); 
@@ -20,7 +20,7 @@
 #include <iostream>
 #include <cstring>
 #include <sstream>
-#include <TGraph.h>
+#include <cmath>
 #include <TBranch.h>
 #include <TBranchElement.h>
 
@@ -51,6 +51,19 @@ TrackerGeometry::TrackerGeometry(TTree * geom_tree)
 	ComputeParameters();
 }
 
+// Constructor using the sensor parameters of DetectorConstruction (used by the digitizer)
+TrackerGeometry::TrackerGeometry(int n_strips, double pitch, double length, double det_thickness)
+{
+    // Default setup/detector parameters, then the sensor ones
+	InitParameters();
+    strips = n_strips;
+    s_pitch = pitch;
+    s_length = length;
+    thickness = det_thickness;
+    // Calculate new parameters relevant to tracker
+	ComputeParameters();
+}
+
 TrackerGeometry::~TrackerGeometry()
 {
     
@@ -201,7 +214,12 @@ void TrackerGeometry::InitParameters(std::string input_macro_file)
     // create a file-reading object
     std::ifstream fin;
     fin.open(input_macro_file); // open proton_no_vis.mac as default
-    if (!fin.good()){exit(-1);}
+    if (!fin.good())
+    {
+        std::cerr << "TrackerGeometry: cannot open " << input_macro_file << ", using the default geometry" << std::endl;
+        InitParameters();
+        return;
+    }
     
     // define variables for all geometry related parameters that will be
     // read in from macro
@@ -1748,6 +1766,74 @@ void TrackerGeometry::ComputeParameters()
 //    std::cout << "The offset in angle of u4 = " << stereo_u4_offset * TMath::RadToDeg() << " deg." << std::endl;
 //    std::cout << "The offset in angle of v4 = " << stereo_v4_offset * TMath::RadToDeg() << " deg." << std::endl;
     
+    BuildPlaneTransforms();
+}
+
+void TrackerGeometry::BuildPlaneTransforms()
+{
+    const TVector3 A[n_planes] = { A_x1, A_u1, A_v1, A_x2, A_u2, A_v2, A_x3, A_u3, A_v3, A_x4, A_u4, A_v4 };
+    const TVector3 D[n_planes] = { D_x1, D_u1, D_v1, D_x2, D_u2, D_v2, D_x3, D_u3, D_v3, D_x4, D_u4, D_v4 };
+    const double stereo[n_planes] = { stereo_x1, stereo_u1, stereo_v1, stereo_x2, stereo_u2, stereo_v2,
+                                      stereo_x3, stereo_u3, stereo_v3, stereo_x4, stereo_u4, stereo_v4 };
+    
+    for(int plane=0; plane<n_planes; plane++)
+    {
+        BuildPlaneTransform(plane, A[plane], D[plane], stereo[plane]);
+    }
+}
+
+void TrackerGeometry::BuildPlaneTransform(int plane, const TVector3 & A, const TVector3 & D, double stereo)
+{
+    PlaneTransform & p = plane_transforms[plane];
+    p.origin = A;
+    p.opp_origin = D;
+    
+    // world_2_det_transform() projects the hit (at the height of the det.) on this axis
+    const TVector3 det_axis = (D - A).Unit();
+    p.axis_x = det_axis.X();
+    p.axis_y = det_axis.Y();
+    
+    p.stereo = stereo;
+    p.sin_stereo = sin(stereo);
+    p.cos_stereo = cos(stereo);
+    p.pitch = s_pitch;
+    
+    p.strip_x.resize(strips);
+    p.strip_y.resize(strips);
+    p.strip_pos.resize(strips);
+    for(int strip_no=1; strip_no<=strips; strip_no++)
+    {
+        // same (float) arithmetic as get_strip_origin() so that both agree exactly
+        const TVector3 strip_origin = get_strip_origin(A, strip_no, stereo);
+        p.strip_x[strip_no-1] = strip_origin.X();
+        p.strip_y[strip_no-1] = strip_origin.Y();
+        p.strip_pos[strip_no-1] = world_2_det(plane, strip_origin.X(), strip_origin.Y());
+    }
+}
+
+// Places a plane as in the simulation: the corners are computed as in ComputeParameters() but
+// around the given centre (x/y position and offset already included) with the full stereo angle
+void TrackerGeometry::set_plane_placement(int plane, const TVector3 & centre, double stereo_angle)
+{
+    TVector3 * const pos[n_planes] = { &x1_pos, &u1_pos, &v1_pos, &x2_pos, &u2_pos, &v2_pos,
+                                       &x3_pos, &u3_pos, &v3_pos, &x4_pos, &u4_pos, &v4_pos };
+    TVector3 * const A[n_planes] = { &A_x1, &A_u1, &A_v1, &A_x2, &A_u2, &A_v2, &A_x3, &A_u3, &A_v3, &A_x4, &A_u4, &A_v4 };
+    TVector3 * const B[n_planes] = { &B_x1, &B_u1, &B_v1, &B_x2, &B_u2, &B_v2, &B_x3, &B_u3, &B_v3, &B_x4, &B_u4, &B_v4 };
+    TVector3 * const C[n_planes] = { &C_x1, &C_u1, &C_v1, &C_x2, &C_u2, &C_v2, &C_x3, &C_u3, &C_v3, &C_x4, &C_u4, &C_v4 };
+    TVector3 * const D[n_planes] = { &D_x1, &D_u1, &D_v1, &D_x2, &D_u2, &D_v2, &D_x3, &D_u3, &D_v3, &D_x4, &D_u4, &D_v4 };
+    double * const stereo[n_planes] = { &stereo_x1, &stereo_u1, &stereo_v1, &stereo_x2, &stereo_u2, &stereo_v2,
+                                        &stereo_x3, &stereo_u3, &stereo_v3, &stereo_x4, &stereo_u4, &stereo_v4 };
+    
+    *pos[plane] = centre;
+    *stereo[plane] = stereo_angle;
+    
+    const double x = centre.X(), y = centre.Y(), z = centre.Z();
+    A[plane]->SetXYZ( -1*diag*cos(origin_angle - stereo_angle) + x, -1*diag*sin(origin_angle - stereo_angle) + y, z );
+    B[plane]->SetXYZ( -1*diag*cos(origin_angle + stereo_angle) + x, diag*sin(origin_angle + stereo_angle) + y, z );
+    C[plane]->SetXYZ( diag*cos(origin_angle - stereo_angle) + x, diag*sin(origin_angle - stereo_angle) + y, z );
+    D[plane]->SetXYZ( diag*cos(origin_angle + stereo_angle) + x, -1*diag*sin(origin_angle + stereo_angle) + y, z );
+    
+    BuildPlaneTransform(plane, *A[plane], *D[plane], stereo_angle);
 }
 
 
@@ -2059,47 +2145,56 @@ double TrackerGeometry::world_2_det_transform(TVector3 det_origin, TVector3 det_
 }
 
 // Checks if a hit is inside a given strip
-bool TrackerGeometry::IsInsideStrip(TVector3 h, TVector3 origin, double stereo_angle)
+bool TrackerGeometry::IsInsideStrip(const TVector3 & h, const TVector3 & origin, double stereo_angle) const
 {
-    
-    // see here for how to do it analytically:
+    // The strip is the rectangle of width s_pitch across the strips (unit vector (cos,-sin))
+    // and length s_length along them (unit vector (sin,cos)) starting at the strip origin, which
+    // is the centre of its bottom edge. Project the hit on both axes, see:
     // http://math.stackexchange.com/questions/190111/how-to-check-if-a-point-is-inside-a-rectangle
-    // probably not much faster than using the IsInside() function that belongs to the TGraph object in root
-    // which probably uses a similar algorithm
-    
-    TVector3 top, btm, A,B,C,D;
-    
-    btm.SetXYZ(origin.X() - 0.5*s_pitch*cos(stereo_angle), origin.Y() + 0.5*s_pitch*sin(stereo_angle), origin.Z());
-    top.SetXYZ(btm.X() + s_length*sin(stereo_angle), btm.Y() + s_length*cos(stereo_angle), btm.Z());
-    A.SetXYZ(btm.X(),btm.Y(),btm.Z());
-    B.SetXYZ(top.X(),top.Y(),top.Z());
+    const double s = sin(stereo_angle);
+    const double c = cos(stereo_angle);
+    const double dx = h.X() - origin.X();
+    const double dy = h.Y() - origin.Y();
+    
+    const double across = dx*c - dy*s;
+    const double along = dx*s + dy*c;
+    return std::fabs(across) <= 0.5*s_pitch && along >= 0 && along <= s_length;
+}
+
+bool TrackerGeometry::IsInsideStrip(int plane, int strip_no, double x, double y) const
+{
+    const PlaneTransform & p = plane_transforms[plane];
+    const double dx = x - p.strip_x[strip_no-1];
+    const double dy = y - p.strip_y[strip_no-1];
     
-    btm.SetXYZ(origin.X() + 0.5*s_pitch*cos(stereo_angle), origin.Y() - 0.5*s_pitch*sin(stereo_angle), origin.Z());
-    top.SetXYZ(btm.X() + s_length*sin(stereo_angle), btm.Y() + s_length*cos(stereo_angle), btm.Z());
-    D.SetXYZ(btm.X(),btm.Y(),btm.Z());
-    C.SetXYZ(top.X(),top.Y(),top.Z());
-    
-    bool IsInside = true;
-    float _X[5];
-    float _Y[5];
-    TGraph * g;
-    
-    _X[0] = A.X();
-    _Y[0] = A.Y();
-    _X[1] = B.X();
-    _Y[1] = B.Y();
-    _X[2] = C.X();
-    _Y[2] = C.Y();
-    _X[3] = D.X();
-    _Y[3] = D.Y();
-    _X[4] = A.X();
-    _Y[4] = A.Y();
-    
-    g = new TGraph(5,_X,_Y);
-    if( !g->IsInside( h.X(),h.Y() ) ) { IsInside = false; }
-    delete g;
-    
-	return IsInside;
+    const double across = dx*p.cos_stereo - dy*p.sin_stereo;
+    const double along = dx*p.sin_stereo + dy*p.cos_stereo;
+    return std::fabs(across) <= 0.5*p.pitch && along >= 0 && along <= s_length;
+}
+
+void TrackerGeometry::get_strip_nos(int plane, int n_hits, const double * x, const double * y, int * strip_no) const
+{
+    // Same projections as IsInsideStrip() but from the det. corner A, where strip n covers
+    // [(n-1)*pitch, n*pitch) across and [0, s_length] along the strips
+    const PlaneTransform & p = plane_transforms[plane];
+    const double x0 = p.origin.X();
+    const double y0 = p.origin.Y();
+    const double c = p.cos_stereo;
+    const double s = p.sin_stereo;
+    const double inv_pitch = 1/p.pitch;
+    const double length = s_length;
+    const int n_strips = strips;
+    
+    for(int i=0; i<n_hits; i++)
+    {
+        const double dx = x[i] - x0;
+        const double dy = y[i] - y0;
+        const double across = (dx*c - dy*s)*inv_pitch;
+        const double along = dx*s + dy*c;
+        const int n = static_cast<int>(across) + 1;
+        const bool inside = across >= 0 && n <= n_strips && along >= 0 && along <= length;
+        strip_no[i] = inside ? n : 0;
+    }
 }
 
 // Returns a vector which points along the centre of a cluster
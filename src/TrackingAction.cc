@@ -13,12 +13,17 @@ TrackingAction::~TrackingAction()
 
 void TrackingAction::PreUserTrackingAction(const G4Track* aTrack)//****
 {
-  if(aTrack->GetParentID()==0 && aTrack->GetUserInformation()==0) //****
+  T01TrackInformation* anInfo = (T01TrackInformation*)(aTrack->GetUserInformation());
+  if(anInfo==0) //****
    {
-     T01TrackInformation* anInfo = new T01TrackInformation(aTrack); //****
+     anInfo = new T01TrackInformation(aTrack); //****
    G4Track* theTrack = (G4Track*)aTrack; //****
    theTrack->SetUserInformation(anInfo);
   }
+  // Secondaries carry a copy of their parent's information: record their own
+  // origin vertex and initial kinetic energy once here, so SensitiveDetector_pix
+  // can read them on every step without any allocation
+  anInfo->SetVertex(aTrack->GetVertexPosition(), aTrack->GetVertexKineticEnergy());
 }
 
 void TrackingAction::PostUserTrackingAction(const G4Track* aTrack) //****